@@ -0,0 +1,335 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <cstring>
+#include <chrono>
+#include <list>
+#ifndef _WIN32
+#include <netdb.h>
+#endif
+
+#include "DnsResolving.h"
+
+#if CONFIG_PROC_HAVE_DRIVERS
+#include <deque>
+#include <condition_variable>
+#endif
+
+using namespace std;
+using namespace chrono;
+
+struct DnsEntry
+{
+	string host;
+	vector<struct sockaddr_storage> addrs;
+	Success success;
+	uint32_t expiryMs;
+	uint32_t usedMs;
+};
+
+static list<struct DnsEntry> entries;
+#if CONFIG_PROC_HAVE_DRIVERS
+// Never destroyed while a thread is waiting on it
+struct DnsWorkers
+{
+	DnsWorkers()
+		: cv()
+		, hostsQueued()
+		, numIdle(0)
+		, stop(false)
+		, threads()
+	{}
+
+	condition_variable cv;
+	deque<string> hostsQueued;
+	size_t numIdle;
+	bool stop;
+	list<thread> threads;
+};
+
+static mutex mtxDns;
+static DnsWorkers *pWorkers = NULL;
+#endif
+
+static uint32_t millis()
+{
+	auto now = steady_clock::now();
+	auto nowMs = time_point_cast<milliseconds>(now);
+	return (uint32_t)nowMs.time_since_epoch().count();
+}
+
+/* Literature
+ * - https://man7.org/linux/man-pages/man3/getaddrinfo.3.html
+ * - https://learn.microsoft.com/en-us/windows/win32/api/ws2tcpip/nf-ws2tcpip-getaddrinfo
+ */
+static Success hostLookup(const string &host, vector<struct sockaddr_storage> &addrs)
+{
+	struct addrinfo hints, *pRes, *pAi;
+	struct sockaddr_storage addr;
+	int res;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_ADDRCONFIG;
+
+	res = ::getaddrinfo(host.c_str(), NULL, &hints, &pRes);
+	if (res)
+	{
+		dbgLog("could not resolve '%s': %s", host.c_str(), gai_strerror(res));
+		return -1;
+	}
+
+	// Order of getaddrinfo() is kept. See RFC 6724
+	for (pAi = pRes; pAi; pAi = pAi->ai_next)
+	{
+		if (pAi->ai_family != AF_INET && pAi->ai_family != AF_INET6)
+			continue;
+
+		if (pAi->ai_addrlen > sizeof(addr))
+			continue;
+
+		memset(&addr, 0, sizeof(addr));
+		memcpy(&addr, pAi->ai_addr, pAi->ai_addrlen);
+
+		addrs.push_back(addr);
+	}
+
+	::freeaddrinfo(pRes);
+
+	return addrs.size() ? Positive : -2;
+}
+
+static list<struct DnsEntry>::iterator entryFind(const string &host)
+{
+	list<struct DnsEntry>::iterator iter;
+
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		if (iter->host == host)
+			break;
+	}
+
+	return iter;
+}
+
+static void entryResultSet(struct DnsEntry &entry, Success success, vector<struct sockaddr_storage> &addrs)
+{
+	entry.success = success;
+	entry.addrs.swap(addrs);
+	entry.expiryMs = millis() +
+		(success == Positive ? CONFIG_PROC_DNS_TTL_MS : CONFIG_PROC_DNS_TTL_NEGATIVE_MS);
+}
+
+// Least recently used entry which is not in progress
+static void entryEvict()
+{
+	list<struct DnsEntry>::iterator iter, iterOldest;
+	uint32_t curTimeMs = millis();
+	uint32_t ageMax = 0;
+
+	if (entries.size() < CONFIG_PROC_DNS_CACHE_SIZE)
+		return;
+
+	iterOldest = entries.end();
+
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		if (iter->success == Pending)
+			continue;
+
+		if (curTimeMs - iter->usedMs < ageMax)
+			continue;
+
+		ageMax = curTimeMs - iter->usedMs;
+		iterOldest = iter;
+	}
+
+	if (iterOldest != entries.end())
+		entries.erase(iterOldest);
+}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+static void workerRun(DnsWorkers *pWrk)
+{
+	vector<struct sockaddr_storage> addrs;
+	list<struct DnsEntry>::iterator iter;
+	Success success;
+	string host;
+
+	unique_lock<mutex> lock(mtxDns);
+
+	while (1)
+	{
+		++pWrk->numIdle;
+		pWrk->cv.wait(lock, [pWrk] { return pWrk->stop || pWrk->hostsQueued.size(); });
+		--pWrk->numIdle;
+
+		if (pWrk->stop)
+			break;
+
+		host = pWrk->hostsQueued.front();
+		pWrk->hostsQueued.pop_front();
+
+		lock.unlock();
+
+		addrs.clear();
+		success = hostLookup(host, addrs);
+
+		lock.lock();
+
+		// Entry may have been evicted or cleared in the meantime
+		iter = entryFind(host);
+		if (iter != entries.end())
+			entryResultSet(*iter, success, addrs);
+	}
+}
+
+static void workersDestruct()
+{
+	if (!pWorkers)
+		return;
+
+	{
+		Guard lock(mtxDns);
+		pWorkers->stop = true;
+	}
+
+	pWorkers->cv.notify_all();
+
+	for (thread &thr : pWorkers->threads)
+		thr.join();
+
+	delete pWorkers;
+	pWorkers = NULL;
+}
+
+// Caller must lock
+static bool workerStart()
+{
+	if (!pWorkers)
+	{
+		pWorkers = new dNoThrow DnsWorkers;
+		if (!pWorkers)
+			return false;
+
+		Processing::globalDestructorRegister(workersDestruct);
+	}
+
+	// Every queued host gets an idle worker if possible
+	if (pWorkers->hostsQueued.size() < pWorkers->numIdle)
+		return true;
+
+	if (pWorkers->threads.size() >= CONFIG_PROC_DNS_NUM_WORKERS)
+		return true;
+
+	pWorkers->threads.push_back(thread(workerRun, pWorkers));
+
+	return true;
+}
+#endif
+
+Success dnsResolve(const string &host, vector<struct sockaddr_storage> &addrs)
+{
+	list<struct DnsEntry>::iterator iter;
+	uint32_t curTimeMs = millis();
+
+	if (!host.size())
+		return errLog(-1, "host not set");
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxDns);
+#endif
+	iter = entryFind(host);
+	if (iter != entries.end())
+	{
+		iter->usedMs = curTimeMs;
+
+		if (iter->success == Pending)
+			return Pending;
+
+		if ((int32_t)(iter->expiryMs - curTimeMs) > 0)
+		{
+			if (iter->success == Positive)
+				addrs = iter->addrs;
+
+			return iter->success;
+		}
+	}
+	else
+	{
+		entryEvict();
+
+		entries.push_front({ host, vector<struct sockaddr_storage>(), Pending, 0, curTimeMs });
+		iter = entries.begin();
+	}
+
+	iter->success = Pending;
+#if CONFIG_PROC_HAVE_DRIVERS
+	if (!workerStart())
+	{
+		entries.erase(iter);
+		return errLog(-2, "could not start resolver");
+	}
+
+	pWorkers->hostsQueued.push_back(host);
+	pWorkers->cv.notify_one();
+
+	return Pending;
+#else
+	vector<struct sockaddr_storage> addrsNew;
+	Success success;
+
+	success = hostLookup(host, addrsNew);
+	entryResultSet(*iter, success, addrsNew);
+
+	if (success == Positive)
+		addrs = iter->addrs;
+
+	return success;
+#endif
+}
+
+void dnsCacheClear()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxDns);
+#endif
+	list<struct DnsEntry>::iterator iter;
+
+	iter = entries.begin();
+	while (iter != entries.end())
+	{
+		// Lookups in progress are kept
+		if (iter->success == Pending)
+			++iter;
+		else
+			iter = entries.erase(iter);
+	}
+}
@@ -0,0 +1,92 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef DNS_RESOLVING_H
+#define DNS_RESOLVING_H
+
+#include <string>
+#include <vector>
+
+#include "Processing.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+// getaddrinfo() doesn't report the record TTL
+#ifndef CONFIG_PROC_DNS_TTL_MS
+#define CONFIG_PROC_DNS_TTL_MS				60000
+#endif
+
+#ifndef CONFIG_PROC_DNS_TTL_NEGATIVE_MS
+#define CONFIG_PROC_DNS_TTL_NEGATIVE_MS		5000
+#endif
+
+#ifndef CONFIG_PROC_DNS_CACHE_SIZE
+#define CONFIG_PROC_DNS_CACHE_SIZE			64
+#endif
+
+// Hosts resolved concurrently. Workers are started on demand
+#ifndef CONFIG_PROC_DNS_NUM_WORKERS
+#define CONFIG_PROC_DNS_NUM_WORKERS			4
+#endif
+
+/*
+  How is a host name resolved?
+  - Results are cached per host for the process
+    - Positive results for CONFIG_PROC_DNS_TTL_MS
+    - Negative results for CONFIG_PROC_DNS_TTL_NEGATIVE_MS
+  - Lookups run on a pool of worker threads. The driver never blocks
+    - Up to CONFIG_PROC_DNS_NUM_WORKERS hosts are resolved concurrently.
+      A host running into the resolver timeout doesn't delay the others
+    - The worker uses getaddrinfo() and therefore the
+      system configuration incl. the hosts file
+  - Without drivers the lookup is done synchronously
+*/
+
+/*
+ * Naming of functions:  objectVerb()
+ * Example:              dnsResolve()
+ */
+
+/*
+ * Return value
+ *   Positive addresses set. Port not set
+ *   Pending  lookup in progress. Try again
+ *   < 0      host unknown
+ */
+Success dnsResolve(const std::string &host, std::vector<struct sockaddr_storage> &addrs);
+void dnsCacheClear();
+
+#endif
@@ -51,31 +51,70 @@
 #include <cstdarg>
 #include <cstdlib>
 #include <cstdio>
-#if CONFIG_PROC_HAVE_DRIVERS
-#include <mutex>
-#endif
+#include <cstring>
+#include <string>
+#include <vector>
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+#include "Processing.h"
+
+#if CONFIG_PROC_HAVE_LOG
+
 using namespace std;
 #if CONFIG_PROC_LOG_HAVE_CHRONO
 using namespace chrono;
 #endif
 
-typedef void (*FuncEntryLogCreate)(
-			const int severity,
-			const char *filename,
-			const char *function,
-			const int line,
-			const int16_t code,
-			const char *msg,
-			const size_t len);
+struct LevelLogOverride
+{
+	char name[32];
+	int8_t lvl;
+	bool isProc;
+};
+
+/*
+ * A sink either gets every entry by callback or
+ * collects entries in a buffer which is read in chunks.
+ * Slots are protected by the entry lock.
+ * Callbacks are called without the lock. They may log
+ * themselves, but these entries don't reach any callback.
+ * A removed callback may still get entries created
+ * before it was removed
+ */
+struct LogSink
+{
+	FuncEntryLogCreate pFct;
+	char *pBuf;
+	size_t sizeBuf;
+	size_t lenBuf;
+	int lvl;
+	uint32_t numDropped;
+};
+
+// Created under the lock. Given to the callbacks after unlocking
+struct LogEntryDeferred
+{
+	int lvlOverride;
+	int severity;
+	const char *filename;
+	const char *function;
+	int line;
+	int16_t code;
+	std::string msg;
+};
 
 static FuncEntryLogCreate pFctEntryLogCreate = NULL;
+static LogSink logSinks[CONFIG_PROC_LOG_NUM_SINKS];
+static thread_local std::vector<LogEntryDeferred> entriesDeferred;
+static thread_local bool inCallback = false;
+// Highest level of all sinks plus one. 0: No sinks
+static LogSlot levelSinksMax(0);
 
 #if CONFIG_PROC_LOG_HAVE_CHRONO
 static system_clock::time_point tOld;
+static system_clock::time_point tEntry;
 const int cDiffSecMax = 9;
 const int cDiffMsMax = 999;
 #endif
@@ -85,21 +124,511 @@ const char *yellow("\033[0;33m");
 const char *reset("\033[37m");
 
 const size_t cLogEntryBufferSize = 1024;
+const int cLevelLogOverrideMax = 127;
 static int levelLog = 3;
 #if CONFIG_PROC_HAVE_DRIVERS
 static mutex mtxPrint;
+static mutex mtxLevels;
+#endif
+
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+static uint16_t rateBurst = CONFIG_PROC_LOG_RATE_BURST;
+static uint32_t ratePerSec = CONFIG_PROC_LOG_RATE_PER_SEC;
+static uint32_t durDuplicateMs = CONFIG_PROC_LOG_DUPLICATE_WINDOW_MS;
+static int rateLevelMax = CONFIG_PROC_LOG_RATE_LEVEL_MAX;
+// Sites with counts not reported yet
+static LogSite *pSitesPending = NULL;
+static uint32_t tSitesFlushMs = 0;
+const uint32_t cSitePendingIdleMs = 1000;
 #endif
+static uint32_t numEntriesSuppressed = 0;
+
+static LevelLogOverride levelLogOverrides[CONFIG_PROC_LOG_NUM_LEVEL_OVERRIDES];
+static size_t numLevelLogOverrides = 0;
+LogSlot levelLogGen(1);
 
 void levelLogSet(int lvl)
 {
 	levelLog = lvl;
 }
 
+static bool levelLogOverrideMatch(const LevelLogOverride *pOvr, const char *name, bool isProc)
+{
+	if (pOvr->isProc != isProc)
+		return false;
+
+	if (isProc)
+		return !strcmp(pOvr->name, name);
+
+	// File overrides may omit the extension
+	size_t len = strlen(pOvr->name);
+
+	if (strncmp(pOvr->name, name, len))
+		return false;
+
+	return !name[len] || name[len] == '.';
+}
+
+/*
+ * Return value
+ *   Positive  override set or removed
+ *   -1        no name given
+ *   -2        name too long
+ *   -3        no free slot available
+ */
+static Success levelLogOverrideSet(const char *name, int lvl, bool isProc)
+{
+	if (!name || !*name)
+		return -1;
+
+	if (strlen(name) >= sizeof(((LevelLogOverride *)NULL)->name))
+		return -2;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxLevels);
+#endif
+	LevelLogOverride *pOvr = levelLogOverrides;
+	LevelLogOverride *pEnd = pOvr + numLevelLogOverrides;
+
+	for (; pOvr < pEnd; ++pOvr)
+	{
+		if (pOvr->isProc == isProc && !strcmp(pOvr->name, name))
+			break;
+	}
+
+	if (lvl < 0)
+	{
+		if (pOvr == pEnd)
+			return Positive;
+
+		*pOvr = *(pEnd - 1);
+		--numLevelLogOverrides;
+	}
+	else
+	{
+		if (pOvr == pEnd)
+		{
+			// No logging here. We hold the lock for the call sites
+			if (numLevelLogOverrides >= CONFIG_PROC_LOG_NUM_LEVEL_OVERRIDES)
+				return -3;
+
+			strcpy(pOvr->name, name);
+			pOvr->isProc = isProc;
+
+			++numLevelLogOverrides;
+		}
+
+		pOvr->lvl = (int8_t)PMIN(lvl, cLevelLogOverrideMax);
+	}
+
+	// Invalidate all cached call site and process levels
+	uint32_t gen = levelLogGen;
+
+	gen = (gen + 1) & 0xFFFFFF;
+	if (!gen)
+		gen = 1;
+
+	levelLogGen = gen;
+
+	return Positive;
+}
+
+Success levelLogFileSet(const char *filename, int lvl)
+{
+	return levelLogOverrideSet(filename, lvl, false);
+}
+
+Success levelLogProcSet(const char *procName, int lvl)
+{
+	return levelLogOverrideSet(procName, lvl, true);
+}
+
+size_t levelLogOverridesStr(char *pBuf, char *pBufEnd)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxLevels);
+#endif
+	char *pBufStart = pBuf;
+	const LevelLogOverride *pOvr = levelLogOverrides;
+	const LevelLogOverride *pEnd = pOvr + numLevelLogOverrides;
+
+	if (!numLevelLogOverrides)
+		dInfo("No log level overrides\n");
+
+	for (; pOvr < pEnd; ++pOvr)
+		dInfo("%-4s  %-26s  %d\n",
+			pOvr->isProc ? "proc" : "file",
+			pOvr->name, pOvr->lvl);
+
+	return pBuf - pBufStart;
+}
+
+int levelLogSlotUpdate(LogSlot &slot, const char *name, bool isProc)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxLevels);
+#endif
+	const LevelLogOverride *pOvr = levelLogOverrides;
+	const LevelLogOverride *pEnd = pOvr + numLevelLogOverrides;
+	int lvl = -1;
+
+	for (; name && pOvr < pEnd; ++pOvr)
+	{
+		if (!levelLogOverrideMatch(pOvr, name, isProc))
+			continue;
+
+		lvl = pOvr->lvl;
+		break;
+	}
+
+	slot = (((uint32_t)levelLogGen) << 8) | (uint8_t)lvl;
+
+	return lvl;
+}
+
+bool logEntryEnabled(const int severity, const int lvlOverride)
+{
+	if (lvlOverride >= 0)
+		return severity <= lvlOverride;
+
+	if (pFctEntryLogCreate)
+		return true;
+
+	if (severity < (int)levelSinksMax)
+		return true;
+#if CONFIG_PROC_LOG_HAVE_STDOUT
+	return severity <= levelLog;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Applies to log entries with severity <= lvlMax.
+ * Debug output stays unthrottled by default
+ */
+void logRateLimitSet(uint16_t numBurst, uint32_t numPerSec, uint32_t durDuplicateWindowMs, int lvlMax)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+	rateBurst = numBurst;
+	ratePerSec = numPerSec;
+	durDuplicateMs = durDuplicateWindowMs;
+	rateLevelMax = lvlMax;
+#else
+	(void)numBurst;
+	(void)numPerSec;
+	(void)durDuplicateWindowMs;
+	(void)lvlMax;
+#endif
+}
+
+uint32_t logEntriesSuppressed()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+	return numEntriesSuppressed;
+}
+
 void entryLogCreateSet(FuncEntryLogCreate pFct)
 {
 	pFctEntryLogCreate = pFct;
 }
 
+static bool sinkUsed(const LogSink *pSink)
+{
+	return pSink->pFct || pSink->pBuf;
+}
+
+static LogSink *sinkGet(int id)
+{
+	if (id < 0 || id >= CONFIG_PROC_LOG_NUM_SINKS)
+		return NULL;
+
+	LogSink *pSink = &logSinks[id];
+
+	if (!sinkUsed(pSink))
+		return NULL;
+
+	return pSink;
+}
+
+static void levelSinksMaxUpdate()
+{
+	const LogSink *pSink = logSinks;
+	const LogSink *pEnd = pSink + CONFIG_PROC_LOG_NUM_SINKS;
+	int lvlMax = -1;
+
+	for (; pSink < pEnd; ++pSink)
+	{
+		if (sinkUsed(pSink))
+			lvlMax = PMAX(lvlMax, pSink->lvl);
+	}
+
+	levelSinksMax = (uint32_t)(lvlMax + 1);
+}
+
+static int sinkAdd(FuncEntryLogCreate pFct, char *pBuf, size_t size, int lvl)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+	LogSink *pSink = logSinks;
+	LogSink *pEnd = pSink + CONFIG_PROC_LOG_NUM_SINKS;
+
+	for (; pSink < pEnd; ++pSink)
+	{
+		if (!sinkUsed(pSink))
+			break;
+	}
+
+	if (pSink == pEnd)
+		return -1;
+
+	pSink->pFct = pFct;
+	pSink->pBuf = pBuf;
+	pSink->sizeBuf = size;
+	pSink->lenBuf = 0;
+	pSink->lvl = PMAX(lvl, -1);
+	pSink->numDropped = 0;
+
+	levelSinksMaxUpdate();
+
+	return int(pSink - logSinks);
+}
+
+// Return: Sink ID. -1 on error
+int logSinkAdd(FuncEntryLogCreate pFct, int lvl)
+{
+	if (!pFct)
+		return -1;
+
+	return sinkAdd(pFct, NULL, 0, lvl);
+}
+
+// Return: Sink ID. -1 on error
+int logSinkBufferAdd(size_t size, int lvl)
+{
+	if (!size)
+		return -1;
+
+	char *pBuf = (char *)malloc(size);
+	if (!pBuf)
+		return -1;
+
+	int id = sinkAdd(NULL, pBuf, size, lvl);
+	if (id < 0)
+		free(pBuf);
+
+	return id;
+}
+
+void logSinkRemove(int id)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+	LogSink *pSink = sinkGet(id);
+	if (!pSink)
+		return;
+
+	free(pSink->pBuf);
+
+	pSink->pFct = NULL;
+	pSink->pBuf = NULL;
+
+	levelSinksMaxUpdate();
+}
+
+void logSinkLevelSet(int id, int lvl)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+	LogSink *pSink = sinkGet(id);
+	if (!pSink)
+		return;
+
+	pSink->lvl = PMAX(lvl, -1);
+
+	levelSinksMaxUpdate();
+}
+
+/*
+ * Moves complete entries from the sink buffer to pBuf.
+ * Each entry is terminated by "\r\n"
+ * Return: Number of bytes moved
+ */
+size_t logSinkBufferRead(int id, char *pBuf, size_t size)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+	LogSink *pSink = sinkGet(id);
+	if (!pSink || !pSink->pBuf || !pSink->lenBuf)
+		return 0;
+
+	size_t len = pSink->lenBuf;
+
+	if (len > size)
+	{
+		// Don't split entries
+		for (len = size; len && pSink->pBuf[len - 1] != '\n'; --len)
+			;
+	}
+
+	if (!len)
+		return 0;
+
+	memcpy(pBuf, pSink->pBuf, len);
+
+	pSink->lenBuf -= len;
+	memmove(pSink->pBuf, pSink->pBuf + len, pSink->lenBuf);
+
+	return len;
+}
+
+uint32_t logSinkEntriesDropped(int id)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxPrint);
+#endif
+	LogSink *pSink = sinkGet(id);
+	if (!pSink)
+		return 0;
+
+	return pSink->numDropped;
+}
+
+static void entryDefer(
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line,
+				const int16_t code,
+				const char *pBufStart,
+				const size_t len)
+{
+	entriesDeferred.emplace_back();
+
+	LogEntryDeferred &entry = entriesDeferred.back();
+
+	entry.lvlOverride = lvlOverride;
+	entry.severity = severity;
+	entry.filename = filename;
+	entry.function = function;
+	entry.line = line;
+	entry.code = code;
+	entry.msg.assign(pBufStart, len);
+}
+
+/*
+ * Must be called without the lock. Slow callbacks
+ * like file or network sinks don't block other threads.
+ * Sinks are copied first. The slots may change meanwhile
+ */
+static void callbacksDispatch()
+{
+	// Logging by a callback. Dispatched by the outer call
+	if (inCallback || entriesDeferred.empty())
+		return;
+
+	FuncEntryLogCreate fcts[CONFIG_PROC_LOG_NUM_SINKS];
+	int lvls[CONFIG_PROC_LOG_NUM_SINKS];
+	FuncEntryLogCreate pFctGlobal;
+	size_t numFcts = 0;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mtxPrint);
+#endif
+		pFctGlobal = pFctEntryLogCreate;
+
+		for (size_t i = 0; i < CONFIG_PROC_LOG_NUM_SINKS; ++i)
+		{
+			if (!logSinks[i].pFct)
+				continue;
+
+			fcts[numFcts] = logSinks[i].pFct;
+			lvls[numFcts] = logSinks[i].lvl;
+			++numFcts;
+		}
+	}
+
+	inCallback = true;
+
+	for (const LogEntryDeferred &entry : entriesDeferred)
+	{
+		if (pFctGlobal)
+			pFctGlobal(entry.severity, entry.filename, entry.function, entry.line,
+						entry.code, entry.msg.c_str(), entry.msg.size());
+
+		for (size_t i = 0; i < numFcts; ++i)
+		{
+			if (entry.severity > (entry.lvlOverride >= 0 ? entry.lvlOverride : lvls[i]))
+				continue;
+
+			fcts[i](entry.severity, entry.filename, entry.function, entry.line,
+						entry.code, entry.msg.c_str(), entry.msg.size());
+		}
+	}
+
+	inCallback = false;
+
+	entriesDeferred.clear();
+}
+
+static void sinksOutput(
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line,
+				const int16_t code,
+				const char *pBufStart,
+				const size_t len,
+				bool deferred)
+{
+	LogSink *pSink = logSinks;
+	LogSink *pEnd = pSink + CONFIG_PROC_LOG_NUM_SINKS;
+
+	for (; pSink < pEnd; ++pSink)
+	{
+		if (!sinkUsed(pSink))
+			continue;
+
+		// Overrides are authoritative for all sinks
+		if (severity > (lvlOverride >= 0 ? lvlOverride : pSink->lvl))
+			continue;
+
+		if (pSink->pFct)
+		{
+			if (deferred || inCallback)
+				continue;
+
+			entryDefer(lvlOverride, severity, filename, function, line, code, pBufStart, len);
+			deferred = true;
+			continue;
+		}
+
+		if (pSink->sizeBuf - pSink->lenBuf < len + 2)
+		{
+			++pSink->numDropped;
+			continue;
+		}
+
+		char *pBuf = pSink->pBuf + pSink->lenBuf;
+
+		memcpy(pBuf, pBufStart, len);
+		pBuf[len] = '\r';
+		pBuf[len + 1] = '\n';
+
+		pSink->lenBuf += len + 2;
+	}
+}
+
 static const char *severityToStr(const int severity)
 {
 	switch (severity)
@@ -114,24 +643,13 @@ static const char *severityToStr(const int severity)
 	return "INV";
 }
 
-int16_t logEntryCreate(const int severity, const char *filename, const char *function, const int line, const int16_t code, const char *msg, ...)
+static size_t prefixCreate(char *pBuf, char *pBufEnd, const int severity, const char *function, const int line)
 {
-#if CONFIG_PROC_HAVE_DRIVERS
-	lock_guard<mutex> lock(mtxPrint); // Guard not defined!
-#endif
-	char *pBufStart = (char *)malloc(cLogEntryBufferSize);
-	if (!pBufStart)
-		return code;
-
-	char *pBuf = pBufStart;
-	char *pBufEnd = pBuf + cLogEntryBufferSize - 1;
-
-	*pBuf = 0;
-	*pBufEnd = 0;
-
+	char *pBufStart = pBuf;
 #if CONFIG_PROC_LOG_HAVE_CHRONO
 	// get time
 	system_clock::time_point t = system_clock::now();
+	tEntry = t;
 	milliseconds durDiffMs = duration_cast<milliseconds>(t - tOld);
 
 	// build day
@@ -191,21 +709,28 @@ int16_t logEntryCreate(const int severity, const char *filename, const char *fun
 					diffMaxed ? '>' : '+', tDiffSec, tDiffMs,
 #endif
 					line, severityToStr(severity), function);
-
-	va_list args;
-
-	va_start(args, msg);
-	pBuf += vsnprintf(pBuf, pBufEnd - pBuf, msg, args);
 	if (pBuf > pBufEnd)
 		pBuf = pBufEnd;
-	va_end(args);
 
+	return pBuf - pBufStart;
+}
+
+static void entryOutput(
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line,
+				const int16_t code,
+				const char *pBufStart,
+				const size_t len)
+{
 #if CONFIG_PROC_LOG_HAVE_STDOUT
 	// create log entry
-	if (severity <= levelLog)
+	if (severity <= (lvlOverride >= 0 ? lvlOverride : levelLog))
 	{
 #if CONFIG_PROC_LOG_HAVE_CHRONO
-		tOld = t;
+		tOld = tEntry;
 #endif
 #ifdef _WIN32
 		HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -235,12 +760,329 @@ int16_t logEntryCreate(const int severity, const char *filename, const char *fun
 			fprintf(stdout, "%s\r\n", pBufStart);
 #endif
 	}
+#else
+	(void)lvlOverride;
 #endif
-	if (pFctEntryLogCreate)
-		pFctEntryLogCreate(severity, filename, function, line, code, pBufStart, pBuf - pBufStart);
+	// Deferred once for all callbacks
+	bool deferred = pFctEntryLogCreate && !inCallback;
+
+	if (deferred)
+		entryDefer(lvlOverride, severity, filename, function, line, code, pBufStart, len);
+
+	sinksOutput(lvlOverride, severity, filename, function, line, code, pBufStart, len, deferred);
+}
+
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+// Token bucket. A fresh call site starts with a full bucket
+static bool siteTokenTake(LogSite *pSite, uint32_t tMs)
+{
+	if (!rateBurst)
+		return true;
+
+	uint32_t numRefill = (uint32_t)(((uint64_t)(tMs - pSite->tRefillMs) * ratePerSec) / 1000);
+
+	if (numRefill)
+	{
+		pSite->numTokensUsed -= PMIN(numRefill, (uint32_t)pSite->numTokensUsed);
+		pSite->tRefillMs = tMs;
+	}
+
+	if (pSite->numTokensUsed >= rateBurst)
+		return false;
+
+	if (!pSite->numTokensUsed)
+		pSite->tRefillMs = tMs;
+
+	++pSite->numTokensUsed;
+
+	return true;
+}
+
+// FNV-1a
+static uint32_t msgHash(const char *pMsg, size_t len)
+{
+	uint32_t h = 2166136261u;
+
+	for (; len; --len)
+	{
+		h ^= (uint8_t)*pMsg++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static uint32_t millis()
+{
+	return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void sitePendingMark(
+				LogSite *pSite,
+				uint32_t tMs,
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line)
+{
+	pSite->filename = filename;
+	pSite->function = function;
+	pSite->line = line;
+	pSite->severity = (int8_t)severity;
+	pSite->lvlOverride = (int8_t)lvlOverride;
+	pSite->tPendingMs = tMs;
+
+	if (pSite->isPending)
+		return;
+
+	pSite->pNextPending = pSitesPending;
+	pSitesPending = pSite;
+	pSite->isPending = true;
+}
+
+static void siteCountsOutput(LogSite *pSite)
+{
+	char buf[160];
+	char *pBuf;
+	char *pBufEnd = buf + sizeof(buf);
+
+	if (pSite->numRepeated)
+	{
+		pBuf = buf;
+		pBuf += prefixCreate(pBuf, pBufEnd, pSite->severity, pSite->function, pSite->line);
+		pBuf += snprintf(pBuf, pBufEnd - pBuf,
+					"last message repeated %u times", (unsigned)pSite->numRepeated);
+		if (pBuf >= pBufEnd)
+			pBuf = pBufEnd - 1;
+
+		entryOutput(pSite->lvlOverride, pSite->severity, pSite->filename,
+					pSite->function, pSite->line, 0, buf, pBuf - buf);
+
+		pSite->numRepeated = 0;
+	}
+
+	if (pSite->numSuppressed)
+	{
+		pBuf = buf;
+		pBuf += prefixCreate(pBuf, pBufEnd, pSite->severity, pSite->function, pSite->line);
+		pBuf += snprintf(pBuf, pBufEnd - pBuf,
+					"%u entries suppressed", (unsigned)pSite->numSuppressed);
+		if (pBuf >= pBufEnd)
+			pBuf = pBufEnd - 1;
+
+		entryOutput(pSite->lvlOverride, pSite->severity, pSite->filename,
+					pSite->function, pSite->line, 0, buf, pBuf - buf);
+
+		pSite->numSuppressed = 0;
+	}
+}
+
+/*
+ * Reports the counts of sites which didn't log
+ * for cSitePendingIdleMs. All of them if forced
+ */
+static void sitesFlush(uint32_t tMs, bool force)
+{
+	LogSite **ppSite = &pSitesPending;
+	LogSite *pSite;
+
+	tSitesFlushMs = tMs;
+
+	while (*ppSite)
+	{
+		pSite = *ppSite;
+
+		if (pSite->numRepeated || pSite->numSuppressed)
+		{
+			if (!force && tMs - pSite->tPendingMs < cSitePendingIdleMs)
+			{
+				ppSite = &pSite->pNextPending;
+				continue;
+			}
+
+			siteCountsOutput(pSite);
+		}
+
+		*ppSite = pSite->pNextPending;
+		pSite->pNextPending = NULL;
+		pSite->isPending = false;
+	}
+}
+#endif
+
+/*
+ * Also called periodically by the log core itself.
+ * Force: When the sinks are flushed
+ */
+void logFlush(bool force)
+{
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mtxPrint);
+#endif
+		if (pSitesPending)
+			sitesFlush(millis(), force);
+	}
+
+	callbacksDispatch();
+#else
+	(void)force;
+#endif
+}
+
+static int16_t entryCreateLocked(
+				LogSite *pSite,
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line,
+				const int16_t code,
+				const char *msg,
+				va_list args)
+{
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+	uint32_t tMs = millis();
+
+	if (pSitesPending && tMs - tSitesFlushMs >= cSitePendingIdleMs)
+		sitesFlush(tMs, false);
+
+	// Only warnings and errors by default
+	if (severity > rateLevelMax)
+		pSite = NULL;
+
+	if (pSite && !siteTokenTake(pSite, tMs))
+	{
+		++pSite->numSuppressed;
+		++numEntriesSuppressed;
+		sitePendingMark(pSite, tMs, lvlOverride, severity, filename, function, line);
+		return code;
+	}
+#endif
+	char *pBufStart = (char *)malloc(cLogEntryBufferSize);
+	if (!pBufStart)
+		return code;
+
+	char *pBuf = pBufStart;
+	char *pBufEnd = pBuf + cLogEntryBufferSize - 1;
+	char *pMsg;
+
+	*pBuf = 0;
+	*pBufEnd = 0;
+
+	pBuf += prefixCreate(pBuf, pBufEnd, severity, function, line);
+	pMsg = pBuf;
+
+	pBuf += vsnprintf(pBuf, pBufEnd - pBuf, msg, args);
+	if (pBuf > pBufEnd)
+		pBuf = pBufEnd;
+
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+	if (pSite && durDuplicateMs)
+	{
+		uint32_t hash = msgHash(pMsg, pBuf - pMsg);
+		bool isDuplicate = hash == pSite->hashLast &&
+					tMs - pSite->tFirstMs < durDuplicateMs;
+
+		if (isDuplicate)
+		{
+			// Duplicates don't consume the rate budget
+			if (pSite->numTokensUsed)
+				--pSite->numTokensUsed;
+
+			++pSite->numRepeated;
+			++numEntriesSuppressed;
+			sitePendingMark(pSite, tMs, lvlOverride, severity, filename, function, line);
+
+			free(pBufStart);
+			return code;
+		}
+
+		if (pSite->numRepeated)
+		{
+			char bufRep[128];
+			char *pBufRep = bufRep;
+			char *pBufRepEnd = bufRep + sizeof(bufRep);
+
+			pBufRep += prefixCreate(pBufRep, pBufRepEnd, severity, function, line);
+			pBufRep += snprintf(pBufRep, pBufRepEnd - pBufRep,
+						"last message repeated %u times", (unsigned)pSite->numRepeated);
+			if (pBufRep >= pBufRepEnd)
+				pBufRep = pBufRepEnd - 1;
+
+			entryOutput(lvlOverride, severity, filename, function, line, code, bufRep, pBufRep - bufRep);
+
+			pSite->numRepeated = 0;
+		}
+
+		pSite->hashLast = hash;
+		pSite->tFirstMs = tMs;
+	}
+
+	if (pSite && pSite->numSuppressed)
+	{
+		pBuf += snprintf(pBuf, pBufEnd - pBuf, " [%u suppressed]", (unsigned)pSite->numSuppressed);
+		if (pBuf > pBufEnd)
+			pBuf = pBufEnd;
+
+		pSite->numSuppressed = 0;
+	}
+#else
+	(void)pSite;
+	(void)pMsg;
+#endif
+	entryOutput(lvlOverride, severity, filename, function, line, code, pBufStart, pBuf - pBufStart);
 
 	free(pBufStart);
 
 	return code;
 }
 
+static void entryCreate(
+				LogSite *pSite,
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line,
+				const int16_t code,
+				const char *msg,
+				va_list args)
+{
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mtxPrint);
+#endif
+		entryCreateLocked(pSite, lvlOverride, severity, filename, function, line, code, msg, args);
+	}
+
+	callbacksDispatch();
+}
+
+int16_t logEntryCreate(const int severity, const char *filename, const char *function, const int line, const int16_t code, const char *msg, ...)
+{
+	va_list args;
+
+	va_start(args, msg);
+	entryCreate(NULL, -1, severity, filename, function, line, code, msg, args);
+	va_end(args);
+
+	return code;
+}
+
+int16_t logEntrySiteCreate(LogSite *pSite, const int lvlOverride, const int severity, const char *filename, const char *function, const int line, const int16_t code, const char *msg, ...)
+{
+	va_list args;
+
+	va_start(args, msg);
+	entryCreate(pSite, lvlOverride, severity, filename, function, line, code, msg, args);
+	va_end(args);
+
+	return code;
+}
+
+#endif
+
+
@@ -0,0 +1,418 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <chrono>
+
+#include "LogFile.h"
+
+#if CONFIG_PROC_LOG_HAVE_FILE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+using namespace chrono;
+
+#if CONFIG_PROC_LOG_HAVE_FILE
+
+struct LogSegmentHeader
+{
+	char magic[8];
+	uint64_t seq;
+	uint64_t offTail;
+	uint64_t sizeSegment;
+	uint8_t reserved[32];
+};
+
+const char cMagicSegment[] = "PLOGSEG1";
+const size_t cSizeMagic = sizeof(((LogSegmentHeader *)0)->magic);
+
+static string pathBase;
+static size_t sizeSeg = 0;
+static size_t numSeg = 0;
+static size_t idxSeg = 0;
+static uint64_t seqSeg = 0;
+static char *pSeg = NULL;
+static LogSegmentHeader *pHdr = NULL;
+static bool rotateFailed = false;
+static uint32_t tRotateMs = 0;
+static uint32_t numDropped = 0;
+static uint32_t numDroppedReported = 0;
+static int idSink = -1;
+#if CONFIG_PROC_HAVE_DRIVERS
+static std::mutex mtxFile;
+#endif
+
+/* Literature
+ * - https://man7.org/linux/man-pages/man2/mmap.2.html
+ * - https://man7.org/linux/man-pages/man2/msync.2.html
+ * - https://man7.org/linux/man-pages/man3/posix_fallocate.3.html
+ */
+
+static string segmentPath(size_t idx)
+{
+	return pathBase + "." + to_string(idx);
+}
+
+static uint64_t segmentSeqGet(size_t idx)
+{
+	LogSegmentHeader hdr;
+	ssize_t lenRead;
+	int fd;
+
+	fd = ::open(segmentPath(idx).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+
+	lenRead = ::read(fd, &hdr, sizeof(hdr));
+	::close(fd);
+
+	if (lenRead != (ssize_t)sizeof(hdr))
+		return 0;
+
+	if (memcmp(hdr.magic, cMagicSegment, cSizeMagic))
+		return 0;
+
+	return hdr.seq;
+}
+
+static void segmentUnmap()
+{
+	if (!pSeg)
+		return;
+
+	::msync(pSeg, sizeSeg, MS_ASYNC);
+	::munmap(pSeg, sizeSeg);
+
+	pSeg = NULL;
+	pHdr = NULL;
+}
+
+// Return: 0 on success. Error number otherwise
+static int segmentMap(size_t idx, uint64_t seq)
+{
+	string path = segmentPath(idx);
+	void *pMap;
+	int fd, res;
+
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return errno;
+
+	// Zero the old content. Readers stop at the tail anyway
+	res = ::ftruncate(fd, 0);
+	if (!res)
+		res = ::ftruncate(fd, (off_t)sizeSeg);
+	if (res)
+		res = errno;
+#if defined(__linux__)
+	// Reserve the blocks now. Otherwise a full disk
+	// would raise SIGBUS while writing to the mapping.
+	// Returns the error number. errno is not set
+	if (!res)
+		res = ::posix_fallocate(fd, 0, (off_t)sizeSeg);
+#endif
+	if (res)
+	{
+		::close(fd);
+		return res;
+	}
+
+	pMap = ::mmap(NULL, sizeSeg, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	res = errno;
+	::close(fd);
+
+	if (pMap == MAP_FAILED)
+		return res;
+
+	pSeg = (char *)pMap;
+	pHdr = (LogSegmentHeader *)pMap;
+
+	memcpy(pHdr->magic, cMagicSegment, cSizeMagic);
+	pHdr->seq = seq;
+	pHdr->sizeSegment = sizeSeg;
+	pHdr->offTail = sizeof(*pHdr);
+
+	idxSeg = idx;
+	seqSeg = seq;
+
+	return 0;
+}
+
+static uint32_t millis()
+{
+	auto now = steady_clock::now();
+	return (uint32_t)duration_cast<milliseconds>(now.time_since_epoch()).count();
+}
+
+// Entry is truncated to the space left in the segment
+static void entryWrite(const char *msg, size_t len)
+{
+	size_t lenLeft = sizeSeg - pHdr->offTail;
+	size_t lenEntry = PMIN(len + 1, lenLeft);
+	char *pTail = pSeg + pHdr->offTail;
+
+	if (!lenEntry)
+		return;
+
+	memcpy(pTail, msg, lenEntry - 1);
+	pTail[lenEntry - 1] = '\n';
+
+	// Commit entry
+	__atomic_store_n(&pHdr->offTail, pHdr->offTail + lenEntry, __ATOMIC_RELEASE);
+}
+
+/*
+ * No log calls in here. We are called by the log core.
+ * Failures are reported once and retried in intervals
+ */
+static bool segmentRotate()
+{
+	uint32_t curTimeMs = millis();
+	char buf[64];
+	int len, res;
+
+	if (rotateFailed && curTimeMs - tRotateMs < CONFIG_PROC_LOG_FILE_RETRY_MS)
+		return false;
+
+	tRotateMs = curTimeMs;
+	segmentUnmap();
+
+	res = segmentMap((idxSeg + 1) % numSeg, seqSeg + 1);
+	if (res)
+	{
+		if (!rotateFailed)
+			fprintf(stderr, "log file: could not rotate segment of %s: %s\r\n",
+					pathBase.c_str(), strerror(res));
+		rotateFailed = true;
+		return false;
+	}
+
+	if (!rotateFailed)
+		return true;
+
+	rotateFailed = false;
+
+	len = snprintf(buf, sizeof(buf), "log file: %u entries dropped",
+					numDropped - numDroppedReported);
+	numDroppedReported = numDropped;
+
+	if (len > 0)
+		entryWrite(buf, PMIN((size_t)len, sizeof(buf) - 1));
+
+	return true;
+}
+
+static bool segmentStart(const char *pPathBase, size_t sizeSegment, size_t numSegments)
+{
+	segmentUnmap();
+
+	rotateFailed = false;
+	numDropped = 0;
+	numDroppedReported = 0;
+
+	pathBase = pPathBase;
+	sizeSeg = sizeSegment;
+	numSeg = numSegments;
+
+	// Continue after the newest existing segment
+	uint64_t seq, seqMax = 0;
+	size_t idxMax = numSeg - 1;
+
+	for (size_t i = 0; i < numSeg; ++i)
+	{
+		seq = segmentSeqGet(i);
+		if (seq <= seqMax)
+			continue;
+
+		seqMax = seq;
+		idxMax = i;
+	}
+
+	return !segmentMap((idxMax + 1) % numSeg, seqMax + 1);
+}
+
+bool logFileStart(const char *pPathBase, size_t sizeSegment, size_t numSegments, int lvl)
+{
+	bool ok;
+
+	logFileStop();
+
+	if (!pPathBase || !*pPathBase)
+		return false;
+
+	if (sizeSegment <= sizeof(LogSegmentHeader) || !numSegments)
+		return false;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mtxFile);
+#endif
+		ok = segmentStart(pPathBase, sizeSegment, numSegments);
+	}
+
+	if (!ok)
+		return false;
+
+	// Not under the file lock. The sink takes it itself
+	idSink = logSinkAdd(logFileEntryCreate, lvl);
+	if (idSink >= 0)
+		return true;
+
+	logFileStop();
+
+	return false;
+}
+
+void logFileStop()
+{
+	if (idSink >= 0)
+		logSinkRemove(idSink);
+	idSink = -1;
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxFile);
+#endif
+	segmentUnmap();
+	sizeSeg = 0;
+}
+
+void logFileSync()
+{
+	// Before the file lock. Output goes through the sinks
+	logFlush(true);
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxFile);
+#endif
+	if (!pSeg)
+		return;
+
+	::msync(pSeg, sizeSeg, MS_SYNC);
+}
+
+uint32_t logFileEntriesDropped()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxFile);
+#endif
+	return numDropped;
+}
+
+void logFileEntryCreate(
+			const int severity,
+			const char *filename,
+			const char *function,
+			const int line,
+			const int16_t code,
+			const char *msg,
+			const size_t len)
+{
+	(void)severity;
+	(void)filename;
+	(void)function;
+	(void)line;
+	(void)code;
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxFile);
+#endif
+	if (!sizeSeg)
+		return; // Not started
+
+	size_t lenPayloadMax = sizeSeg - sizeof(*pHdr);
+	size_t lenEntry = PMIN(len + 1, lenPayloadMax);
+
+	if ((!pSeg || pHdr->offTail + lenEntry > sizeSeg) && !segmentRotate())
+	{
+		++numDropped;
+		return;
+	}
+
+	// Report of dropped entries written by the rotation
+	if (pHdr->offTail + lenEntry > sizeSeg && !segmentRotate())
+	{
+		++numDropped;
+		return;
+	}
+
+	entryWrite(msg, len);
+}
+
+#else
+
+bool logFileStart(const char *pPathBase, size_t sizeSegment, size_t numSegments, int lvl)
+{
+	(void)pPathBase;
+	(void)sizeSegment;
+	(void)numSegments;
+	(void)lvl;
+	return false;
+}
+
+void logFileStop()
+{
+}
+
+void logFileSync()
+{
+}
+
+uint32_t logFileEntriesDropped()
+{
+	return 0;
+}
+
+void logFileEntryCreate(
+			const int severity,
+			const char *filename,
+			const char *function,
+			const int line,
+			const int16_t code,
+			const char *msg,
+			const size_t len)
+{
+	(void)severity;
+	(void)filename;
+	(void)function;
+	(void)line;
+	(void)code;
+	(void)msg;
+	(void)len;
+}
+
+#endif
+
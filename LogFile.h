@@ -0,0 +1,97 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#ifndef LOG_FILE_H
+#define LOG_FILE_H
+
+#include "Processing.h"
+
+#ifndef CONFIG_PROC_LOG_HAVE_FILE
+#if defined(__unix__) || defined(__APPLE__)
+#define CONFIG_PROC_LOG_HAVE_FILE				1
+#else
+#define CONFIG_PROC_LOG_HAVE_FILE				0
+#endif
+#endif
+
+#ifndef CONFIG_PROC_LOG_FILE_SIZE_SEGMENT
+#define CONFIG_PROC_LOG_FILE_SIZE_SEGMENT		(1024 * 1024)
+#endif
+
+#ifndef CONFIG_PROC_LOG_FILE_NUM_SEGMENTS
+#define CONFIG_PROC_LOG_FILE_NUM_SEGMENTS		4
+#endif
+
+// After a failed rotation
+#ifndef CONFIG_PROC_LOG_FILE_RETRY_MS
+#define CONFIG_PROC_LOG_FILE_RETRY_MS			1000
+#endif
+
+/*
+  What is the log file?
+  - A log sink writing into preallocated, memory mapped segments
+    - <pathBase>.0 .. <pathBase>.<numSegments - 1>
+    - No write() call per entry
+  - Segments are rotated when full. The oldest segment is overwritten
+  - Every segment starts with a header
+    - Magic      .. "PLOGSEG1"
+    - Sequence   .. Increasing number of the segment. Used for ordering
+    - Tail       .. Offset of the committed end of the entries
+  - The tail is updated after each entry. Entries written before
+    a crash of the application are therefore kept by the kernel
+  - If a rotation fails (disk full, mmap error) the failure is
+    reported once on stderr. Entries are dropped and counted
+    until a retry succeeds. The count is written to the new segment
+  - Registered as a sink of the log core. Runs together
+    with other sinks like the network debug peer
+  - Usage
+    - logFileStart("/var/log/app");
+    - logFileStop();
+*/
+
+bool logFileStart(const char *pPathBase,
+			size_t sizeSegment = CONFIG_PROC_LOG_FILE_SIZE_SEGMENT,
+			size_t numSegments = CONFIG_PROC_LOG_FILE_NUM_SEGMENTS,
+			int lvl = 3);
+void logFileStop();
+void logFileSync();
+uint32_t logFileEntriesDropped();
+void logFileEntryCreate(
+			const int severity,
+			const char *filename,
+			const char *function,
+			const int line,
+			const int16_t code,
+			const char *msg,
+			const size_t len);
+
+#endif
+
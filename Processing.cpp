@@ -30,8 +30,13 @@
 
 #include "Processing.h"
 
+#if CONFIG_PROC_LOG_LEVEL_MAX >= 5
 #define coreLog(m, ...)					(genericLog(5, 0, "%-41s " m, __PROC_FILENAME__, ##__VA_ARGS__))
-#define procCoreLog(m, ...)				(genericLog(5, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
+#define procCoreLog(m, ...)				(procGenericLog(5, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
+#else
+#define coreLog(m, ...)					(logEntryDisabled(0))
+#define procCoreLog(m, ...)				(logEntryDisabled(0))
+#endif
 
 #if CONFIG_PROC_HAVE_DRIVERS
 #define CONFIG_PROC_TITLE_NEW_DRIVER
@@ -96,6 +101,8 @@ FuncGlobDestruct *Processing::pGlobalDestructors = NULL;
 size_t Processing::sleepInternalDriveUs = 2000;
 size_t Processing::numBurstInternalDrive = 13;
 FuncInternalDrive Processing::pFctInternalDrive = Processing::internalDrive;
+FuncInternalSleep Processing::pFctInternalSleep = Processing::internalSleep;
+thread_local FuncInternalSleep Processing::pFctInternalSleepThread = NULL;
 FuncDriverInternalCreate Processing::pFctDriverInternalCreate = Processing::driverInternalCreate;
 FuncDriverInternalCleanUp Processing::pFctDriverInternalCleanUp = Processing::driverInternalCleanUp;
 #endif
@@ -486,6 +493,92 @@ size_t Processing::processTreeStr(char *pBuf, char *pBufEnd, bool detailed, bool
 	return pBuf - pBufStart;
 }
 
+/*
+ * Moves a child to another parent without interrupting it.
+ * Both parents must be driven by the same thread and
+ * the hand over must be done in process() or shutdown()
+ */
+Processing *Processing::childHandOver(Processing *pChild, Processing *pParentNew)
+{
+	if (!pChild || !pParentNew)
+	{
+		procErrLog(-1, "could not hand over child. NULL pointer");
+		return NULL;
+	}
+
+	if (pChild == this || pParentNew == pChild)
+	{
+		procErrLog(-1, "could not hand over child. invalid parent");
+		return NULL;
+	}
+
+	if (pParentNew == this)
+		return pChild;
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+	if (pParentNew->mNumChildren >= pParentNew->mNumChildrenMax)
+	{
+		procErrLog(-2, "could not hand over child. maximum number of children reached");
+		return NULL;
+	}
+#endif
+	bool found = false;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mChildListMtx);
+#endif
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+		ChildIter iter = mChildList.begin();
+		for (; iter != mChildList.end(); ++iter)
+		{
+			if (*iter != pChild)
+				continue;
+
+			mChildList.erase(iter);
+			--mNumChildren;
+			found = true;
+
+			break;
+		}
+#else
+		Processing **pChildListElem = mpChildList;
+		for (; pChildListElem && *pChildListElem; ++pChildListElem)
+		{
+			if (*pChildListElem != pChild)
+				continue;
+
+			childElemErase(pChildListElem);
+			found = true;
+
+			break;
+		}
+#endif
+	}
+
+	if (!found)
+	{
+		procErrLog(-3, "could not hand over child. not my child");
+		return NULL;
+	}
+
+	// Grand children keep their level. Only used for display
+	pChild->mLevelTree = pParentNew->mLevelTree + 1;
+	if (pChild->mDriver == DrivenByParent)
+		pChild->mLevelDriver = pParentNew->mLevelDriver;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(pParentNew->mChildListMtx);
+#endif
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+		pParentNew->mChildList.push_back(pChild);
+		++pParentNew->mNumChildren;
+#else
+		pParentNew->childElemAdd(pChild);
+#endif
+	}
+
+	return pChild;
+}
+
 void Processing::undrivenSet(Processing *pChild)
 {
 	pChild->mStatDrv |= PsbDrvUndriven;
@@ -667,6 +760,27 @@ void Processing::internalDriveSet(FuncInternalDrive pFctDrive)
 	pFctInternalDrive = pFctDrive;
 }
 
+/*
+ * The sleep function of the internal drivers may
+ * return early. For example on socket events
+ */
+void Processing::internalSleepSet(FuncInternalSleep pFctSleep)
+{
+	if (!pFctSleep)
+		return;
+
+	pFctInternalSleep = pFctSleep;
+}
+
+/*
+ * Sleep function of the internal driver running on the
+ * calling thread only. Takes precedence over internalSleepSet()
+ */
+void Processing::internalSleepThreadSet(FuncInternalSleep pFctSleep)
+{
+	pFctInternalSleepThread = pFctSleep;
+}
+
 void Processing::driverInternalCreateAndCleanUpSet(
 			FuncDriverInternalCreate pFctCreate,
 			FuncDriverInternalCleanUp pFctCleanUp)
@@ -684,6 +798,9 @@ void Processing::driverInternalCreateAndCleanUpSet(
 Processing::Processing(const char *name)
 	: mState(0)
 	, mStateOld(0)
+#if CONFIG_PROC_HAVE_LOG
+	, mLevelLogProc(0)
+#endif
 	, mLevelTree(0)
 	, mLevelDriver(0)
 	, mName(name)
@@ -1125,7 +1242,12 @@ void Processing::internalDrive(void *pProc)
 			pChild->treeTick();
 
 		if (sleepInternalDriveUs)
-			this_thread::sleep_for(chrono::microseconds(sleepInternalDriveUs));
+		{
+			if (pFctInternalSleepThread)
+				pFctInternalSleepThread(sleepInternalDriveUs);
+			else
+				pFctInternalSleep(sleepInternalDriveUs);
+		}
 
 		if (pChild->progress())
 			continue;
@@ -1135,6 +1257,11 @@ void Processing::internalDrive(void *pProc)
 	}
 }
 
+void Processing::internalSleep(size_t delayUs)
+{
+	this_thread::sleep_for(chrono::microseconds(delayUs));
+}
+
 void *Processing::driverInternalCreate(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver)
 {
 	(void)pConfigDriver;
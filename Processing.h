@@ -43,6 +43,10 @@
 #define CONFIG_PROC_HAVE_LOG					0
 #endif
 
+#ifndef CONFIG_PROC_LOG_LEVEL_MAX
+#define CONFIG_PROC_LOG_LEVEL_MAX				5
+#endif
+
 #ifndef CONFIG_PROC_HAVE_DRIVERS
 #if defined(__STDCPP_THREADS__)
 #define CONFIG_PROC_HAVE_DRIVERS				1
@@ -114,9 +118,37 @@
 #if CONFIG_PROC_HAVE_DRIVERS
 #include <thread>
 #include <mutex>
+#include <atomic>
 typedef std::lock_guard<std::mutex> Guard;
 #endif
 
+#ifndef CONFIG_PROC_LOG_NUM_LEVEL_OVERRIDES
+#define CONFIG_PROC_LOG_NUM_LEVEL_OVERRIDES		8
+#endif
+
+// Highest severity which is rate limited. Default: Warnings and errors
+#ifndef CONFIG_PROC_LOG_RATE_LEVEL_MAX
+#define CONFIG_PROC_LOG_RATE_LEVEL_MAX			2
+#endif
+
+// Per call site. 0: Disabled
+#ifndef CONFIG_PROC_LOG_RATE_BURST
+#define CONFIG_PROC_LOG_RATE_BURST				20
+#endif
+
+#ifndef CONFIG_PROC_LOG_RATE_PER_SEC
+#define CONFIG_PROC_LOG_RATE_PER_SEC			10
+#endif
+
+#ifndef CONFIG_PROC_LOG_NUM_SINKS
+#define CONFIG_PROC_LOG_NUM_SINKS				4
+#endif
+
+// Per call site. 0: Disabled
+#ifndef CONFIG_PROC_LOG_DUPLICATE_WINDOW_MS
+#define CONFIG_PROC_LOG_DUPLICATE_WINDOW_MS		10000
+#endif
+
 #ifdef _MSC_VER
 #include <BaseTsd.h>
 #ifndef _SSIZE_T_DEFINED
@@ -144,6 +176,18 @@ typedef void (*FuncGlobDestruct)();
 typedef void (*FuncInternalDrive)(void *pProc);
 typedef void * /* pDriver */ (*FuncDriverInternalCreate)(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver);
 typedef void (*FuncDriverInternalCleanUp)(void *pDriver);
+typedef void (*FuncInternalSleep)(size_t delayUs);
+
+/*
+ * Cached log level override of a call site or a process
+ * - Bits 31..8: Generation of the log level configuration
+ * - Bits  7..0: Level override. 0xFF: None
+ */
+#if CONFIG_PROC_HAVE_DRIVERS
+typedef std::atomic<uint32_t> LogSlot;
+#else
+typedef uint32_t LogSlot;
+#endif
 
 class Processing
 {
@@ -162,6 +206,7 @@ public:
 	bool shutdownDone() const;
 
 	size_t processTreeStr(char *pBuf, char *pBufEnd, bool detailed = true, bool colored = false);
+	Processing *childHandOver(Processing *pChild, Processing *pParentNew);
 #if CONFIG_PROC_HAVE_DRIVERS
 	void configDriverSet(void *pConfigDriver);
 #endif
@@ -181,6 +226,8 @@ public:
 	static void sleepInternalDriveSet(std::chrono::milliseconds delay);
 	static void numBurstInternalDriveSet(size_t numBurst);
 	static void internalDriveSet(FuncInternalDrive pFctDrive);
+	static void internalSleepSet(FuncInternalSleep pFctSleep);
+	static void internalSleepThreadSet(FuncInternalSleep pFctSleep);
 	static void driverInternalCreateAndCleanUpSet(
 			FuncDriverInternalCreate pFctCreate,
 			FuncDriverInternalCleanUp pFctCleanUp);
@@ -219,6 +266,9 @@ protected:
 
 	uint8_t mState;
 	uint8_t mStateOld;
+#if CONFIG_PROC_HAVE_LOG
+	mutable LogSlot mLevelLogProc;
+#endif
 
 private:
 	// This area is used by the abstract process
@@ -261,6 +311,7 @@ private:
 	static void parentalDrive(Processing *pChild);
 #if CONFIG_PROC_HAVE_DRIVERS
 	static void internalDrive(void *pProc);
+	static void internalSleep(size_t delayUs);
 	static void *driverInternalCreate(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver);
 	static void driverInternalCleanUp(void *pDriver);
 
@@ -268,6 +319,8 @@ private:
 	static size_t sleepInternalDriveUs;
 	static size_t numBurstInternalDrive;
 	static FuncInternalDrive pFctInternalDrive;
+	static FuncInternalSleep pFctInternalSleep;
+	static thread_local FuncInternalSleep pFctInternalSleepThread;
 	static FuncDriverInternalCreate pFctDriverInternalCreate;
 	static FuncDriverInternalCleanUp pFctDriverInternalCleanUp;
 #endif
@@ -290,7 +343,6 @@ private:
 #endif
 #define __PROC_FILENAME__ (procStrrChr(__FILE__, '/') ? procStrrChr(__FILE__, '/') + 1 : __FILE__)
 
-#if CONFIG_PROC_HAVE_LOG
 typedef void (*FuncEntryLogCreate)(
 			const int severity,
 			const char *filename,
@@ -300,8 +352,56 @@ typedef void (*FuncEntryLogCreate)(
 			const char *msg,
 			const size_t len);
 
+#if CONFIG_PROC_HAVE_LOG
+/*
+ * State of a log call site
+ * - Cached level override
+ * - Token bucket for rate limiting
+ * - Suppression of duplicates
+ * - Pending counts. Reported by logFlush() if
+ *   the site doesn't log again
+ * Everything except the level slot is protected by the log core
+ */
+struct LogSite
+{
+	LogSlot lvl;
+	uint32_t tRefillMs;
+	uint32_t tFirstMs;
+	uint32_t hashLast;
+	uint16_t numTokensUsed;
+	uint32_t numSuppressed;
+	uint32_t numRepeated;
+
+	// pending counts
+	LogSite *pNextPending;
+	const char *filename;
+	const char *function;
+	int line;
+	int8_t severity;
+	int8_t lvlOverride;
+	bool isPending;
+	uint32_t tPendingMs;
+};
+
+extern LogSlot levelLogGen;
+
 void levelLogSet(int lvl);
+Success levelLogFileSet(const char *filename, int lvl);
+Success levelLogProcSet(const char *procName, int lvl);
+size_t levelLogOverridesStr(char *pBuf, char *pBufEnd);
+int levelLogSlotUpdate(LogSlot &slot, const char *name, bool isProc);
+bool logEntryEnabled(const int severity, const int lvlOverride);
+void logRateLimitSet(uint16_t numBurst, uint32_t numPerSec, uint32_t durDuplicateWindowMs,
+				int lvlMax = CONFIG_PROC_LOG_RATE_LEVEL_MAX);
+uint32_t logEntriesSuppressed();
+void logFlush(bool force = false);
 void entryLogCreateSet(FuncEntryLogCreate pFct);
+int logSinkAdd(FuncEntryLogCreate pFct, int lvl);
+int logSinkBufferAdd(size_t size, int lvl);
+void logSinkRemove(int id);
+void logSinkLevelSet(int id, int lvl);
+size_t logSinkBufferRead(int id, char *pBuf, size_t size);
+uint32_t logSinkEntriesDropped(int id);
 int16_t logEntryCreate(
 				const int severity,
 				const char *filename,
@@ -309,12 +409,116 @@ int16_t logEntryCreate(
 				const int line,
 				const int16_t code,
 				const char *msg, ...);
-#define genericLog(l, c, m, ...)			(logEntryCreate(l, __PROC_FILENAME__, __func__, __LINE__, c, m, ##__VA_ARGS__))
+int16_t logEntrySiteCreate(
+				LogSite *pSite,
+				const int lvlOverride,
+				const int severity,
+				const char *filename,
+				const char *function,
+				const int line,
+				const int16_t code,
+				const char *msg, ...);
+
+// Return: Level override for file or process. -1 if none
+inline int levelLogSlotGet(LogSlot &slot, const char *name, bool isProc)
+{
+	uint32_t val = slot;
+
+	if ((val >> 8) == levelLogGen)
+		return (int8_t)(val & 0xFF);
+
+	return levelLogSlotUpdate(slot, name, isProc);
+}
+
+#define dLevelLogNone					-1
+#define dLevelLogProc					levelLogSlotGet(this->mLevelLogProc, this->procName(), true)
+
+#define genericLogImpl(p, l, c, m, ...) \
+	([&](const char *pFctLog) -> int16_t \
+	{ \
+		static LogSite site; \
+		int lvlOverride = p; \
+		if (lvlOverride < 0) \
+			lvlOverride = levelLogSlotGet(site.lvl, __PROC_FILENAME__, false); \
+		if (!logEntryEnabled(l, lvlOverride)) \
+			return c; \
+		return logEntrySiteCreate(&site, lvlOverride, l, __PROC_FILENAME__, pFctLog, __LINE__, c, m, ##__VA_ARGS__); \
+	}(__func__))
+
+#define genericLog(l, c, m, ...)			genericLogImpl(dLevelLogNone, l, c, m, ##__VA_ARGS__)
+#define procGenericLog(l, c, m, ...)		genericLogImpl(dLevelLogProc, l, c, m, ##__VA_ARGS__)
 #else
 inline void levelLogSet(int lvl)
 {
 	(void)lvl;
 }
+inline Success levelLogFileSet(const char *filename, int lvl)
+{
+	(void)filename;
+	(void)lvl;
+	return -4;
+}
+inline Success levelLogProcSet(const char *procName, int lvl)
+{
+	(void)procName;
+	(void)lvl;
+	return -4;
+}
+inline size_t levelLogOverridesStr(char *pBuf, char *pBufEnd)
+{
+	(void)pBuf;
+	(void)pBufEnd;
+	return 0;
+}
+inline void logRateLimitSet(uint16_t numBurst, uint32_t numPerSec, uint32_t durDuplicateWindowMs,
+				int lvlMax = CONFIG_PROC_LOG_RATE_LEVEL_MAX)
+{
+	(void)numBurst;
+	(void)numPerSec;
+	(void)durDuplicateWindowMs;
+	(void)lvlMax;
+}
+inline void logFlush(bool force = false)
+{
+	(void)force;
+}
+inline uint32_t logEntriesSuppressed()
+{
+	return 0;
+}
+inline int logSinkAdd(FuncEntryLogCreate pFct, int lvl)
+{
+	(void)pFct;
+	(void)lvl;
+	return -1;
+}
+inline int logSinkBufferAdd(size_t size, int lvl)
+{
+	(void)size;
+	(void)lvl;
+	return -1;
+}
+inline void logSinkRemove(int id)
+{
+	(void)id;
+}
+inline void logSinkLevelSet(int id, int lvl)
+{
+	(void)id;
+	(void)lvl;
+}
+inline size_t logSinkBufferRead(int id, char *pBuf, size_t size)
+{
+	(void)id;
+	(void)pBuf;
+	(void)size;
+	return 0;
+}
+inline uint32_t logSinkEntriesDropped(int id)
+{
+	(void)id;
+	return 0;
+}
 #define entryLogCreateSet(pFct)
 inline int16_t logEntryCreateDummy(
 				const int severity,
@@ -332,17 +536,50 @@ inline int16_t logEntryCreateDummy(
 	return code;
 }
 #define genericLog(l, c, m, ...)	(logEntryCreateDummy(l, __PROC_FILENAME__, __func__, __LINE__, c, m, ##__VA_ARGS__))
+#define procGenericLog(l, c, m, ...)	genericLog(l, c, m, ##__VA_ARGS__)
 #endif
 
+/*
+ * Compile time ceiling for the log level
+ * Log calls above this level expand to nothing.
+ * Their arguments are not evaluated
+ */
+inline int16_t logEntryDisabled(const int16_t code)
+{
+	return code;
+}
+
+#if CONFIG_PROC_LOG_LEVEL_MAX >= 1
 #define errLog(c, m, ...)				(c < 0 ? genericLog(1, c, "%-41s " m, __PROC_FILENAME__, ##__VA_ARGS__) : c)
+#define procErrLog(c, m, ...)				(c < 0 ? procGenericLog(1, c, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__) : c)
+#else
+#define errLog(c, m, ...)				(logEntryDisabled(c))
+#define procErrLog(c, m, ...)				(logEntryDisabled(c))
+#endif
+
+#if CONFIG_PROC_LOG_LEVEL_MAX >= 2
 #define wrnLog(m, ...)					(genericLog(2, 0, "%-41s " m, __PROC_FILENAME__, ##__VA_ARGS__))
+#define procWrnLog(m, ...)				(procGenericLog(2, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
+#else
+#define wrnLog(m, ...)					(logEntryDisabled(0))
+#define procWrnLog(m, ...)				(logEntryDisabled(0))
+#endif
+
+#if CONFIG_PROC_LOG_LEVEL_MAX >= 3
 #define infLog(m, ...)					(genericLog(3, 0, "%-41s " m, __PROC_FILENAME__, ##__VA_ARGS__))
-#define dbgLog(m, ...)					(genericLog(4, 0, "%-41s " m, __PROC_FILENAME__, ##__VA_ARGS__))
+#define procInfLog(m, ...)				(procGenericLog(3, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
+#else
+#define infLog(m, ...)					(logEntryDisabled(0))
+#define procInfLog(m, ...)				(logEntryDisabled(0))
+#endif
 
-#define procErrLog(c, m, ...)				(c < 0 ? genericLog(1, c, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__) : c)
-#define procWrnLog(m, ...)				(genericLog(2, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
-#define procInfLog(m, ...)				(genericLog(3, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
-#define procDbgLog(m, ...)				(genericLog(4, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
+#if CONFIG_PROC_LOG_LEVEL_MAX >= 4
+#define dbgLog(m, ...)					(genericLog(4, 0, "%-41s " m, __PROC_FILENAME__, ##__VA_ARGS__))
+#define procDbgLog(m, ...)				(procGenericLog(4, 0, "%p %-26s " m, this, this->procName(), ##__VA_ARGS__))
+#else
+#define dbgLog(m, ...)					(logEntryDisabled(0))
+#define procDbgLog(m, ...)				(logEntryDisabled(0))
+#endif
 
 #if CONFIG_PROC_HAVE_LIB_STD_C
 #define dInfoDebugPrefix
@@ -0,0 +1,343 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <cstring>
+
+#include "SocketEvents.h"
+
+#if CONFIG_PROC_HAVE_EPOLL
+#include <vector>
+#include <unistd.h>
+#include <sys/epoll.h>
+#endif
+
+using namespace std;
+
+#if CONFIG_PROC_HAVE_EPOLL
+
+/* Literature
+ * - https://man7.org/linux/man-pages/man7/epoll.7.html
+ * - https://man7.org/linux/man-pages/man2/epoll_ctl.2.html
+ * - https://man7.org/linux/man-pages/man2/epoll_wait.2.html
+ */
+
+struct SocketReactor
+{
+	SocketReactor()
+		: fdEpoll(::epoll_create1(EPOLL_CLOEXEC))
+		, numRegistered(0)
+		, gen(1)
+		, evtsByFd()
+	{}
+
+	~SocketReactor()
+	{
+		if (fdEpoll >= 0)
+			::close(fdEpoll);
+	}
+
+	int fdEpoll;
+	size_t numRegistered;
+	uint32_t gen;
+	// Events are assigned by file descriptor. Records of
+	// unregistered sockets are therefore never touched
+	vector<SocketEvents *> evtsByFd;
+#if CONFIG_PROC_HAVE_DRIVERS
+	mutex mtx;
+#endif
+};
+
+const int cNumEventsPollMax = 64;
+
+static thread_local SocketReactor reactorThread;
+
+static uint32_t epollToBits(uint32_t events)
+{
+	uint32_t bits = 0;
+
+	if (events & EPOLLIN)
+		bits |= SockEvtRead;
+
+	if (events & EPOLLOUT)
+		bits |= SockEvtWrite;
+
+	if (events & (EPOLLHUP | EPOLLRDHUP))
+		bits |= SockEvtHup;
+
+	if (events & EPOLLERR)
+		bits |= SockEvtErr;
+
+	return bits;
+}
+
+static uint32_t bitsToEpoll(uint32_t bits)
+{
+	uint32_t events = EPOLLRDHUP;
+
+	if (bits & SockEvtRead)
+		events |= EPOLLIN;
+
+	if (bits & SockEvtWrite)
+		events |= EPOLLOUT;
+
+	return events;
+}
+
+// Return: Number of events not pending already
+static int reactorPoll(SocketReactor *pReactor, int timeoutMs)
+{
+	struct epoll_event events[cNumEventsPollMax];
+	int numEvents, numEventsNew = 0;
+	uint32_t bits;
+
+	numEvents = ::epoll_wait(pReactor->fdEpoll, events, cNumEventsPollMax, timeoutMs);
+	if (numEvents < 0)
+		numEvents = 0;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pReactor->mtx);
+#endif
+	for (int i = 0; i < numEvents; ++i)
+	{
+		int fd = events[i].data.fd;
+
+		if (fd < 0 || (size_t)fd >= pReactor->evtsByFd.size())
+			continue;
+
+		SocketEvents *pEvts = pReactor->evtsByFd[fd];
+		if (!pEvts)
+			continue;
+
+		bits = epollToBits(events[i].events);
+		if (bits & ~pEvts->pending)
+			++numEventsNew;
+
+		pEvts->pending |= bits;
+	}
+
+	++pReactor->gen;
+
+	return numEventsNew;
+}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+// Replaces the sleep of the internal driver owning the reactor
+static void reactorSleep(size_t delayUs)
+{
+	SocketReactor *pReactor = &reactorThread;
+	chrono::steady_clock::time_point tStart;
+	chrono::microseconds durElapsed;
+
+	if (!pReactor->numRegistered || delayUs < 1000)
+	{
+		if (pReactor->numRegistered)
+			reactorPoll(pReactor, 0);
+
+		this_thread::sleep_for(chrono::microseconds(delayUs));
+		return;
+	}
+
+	tStart = chrono::steady_clock::now();
+
+	if (reactorPoll(pReactor, (int)(delayUs / 1000)))
+		return;
+
+	// Woken by events the owners did not consume yet. Being level-triggered,
+	// epoll reports them again immediately. Sleep the remaining interval
+	durElapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - tStart);
+	if ((size_t)durElapsed.count() < delayUs)
+		this_thread::sleep_for(chrono::microseconds(delayUs) - durElapsed);
+}
+#endif
+
+bool sockEvtsRegister(SocketEvents &evts, SOCKET fd, uint32_t interest)
+{
+	SocketReactor *pReactor = &reactorThread;
+	struct epoll_event event;
+	int res;
+
+	if (evts.pReactor || fd < 0 || pReactor->fdEpoll < 0)
+		return false;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pReactor->mtx);
+
+	// Only the driver owning this reactor waits on it
+	if (!pReactor->numRegistered)
+		Processing::internalSleepThreadSet(reactorSleep);
+#endif
+	if ((size_t)fd >= pReactor->evtsByFd.size())
+		pReactor->evtsByFd.resize(fd + 1, NULL);
+
+	memset(&event, 0, sizeof(event));
+	event.events = bitsToEpoll(interest);
+	event.data.fd = fd;
+
+	res = ::epoll_ctl(pReactor->fdEpoll, EPOLL_CTL_ADD, fd, &event);
+	if (res)
+		return false;
+
+	pReactor->evtsByFd[fd] = &evts;
+	++pReactor->numRegistered;
+
+	evts.pReactor = pReactor;
+	evts.fd = fd;
+	evts.interest = interest;
+	// Don't miss data received before the registration
+	evts.pending = interest;
+	evts.gen = pReactor->gen;
+
+	return true;
+}
+
+bool sockEvtsInterestSet(SocketEvents &evts, uint32_t interest)
+{
+	SocketReactor *pReactor = (SocketReactor *)evts.pReactor;
+	struct epoll_event event;
+	int res;
+
+	if (!pReactor)
+		return false;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pReactor->mtx);
+#endif
+	if (evts.interest == interest)
+		return true;
+
+	memset(&event, 0, sizeof(event));
+	event.events = bitsToEpoll(interest);
+	event.data.fd = evts.fd;
+
+	res = ::epoll_ctl(pReactor->fdEpoll, EPOLL_CTL_MOD, evts.fd, &event);
+	if (res)
+		return false;
+
+	evts.interest = interest;
+
+	return true;
+}
+
+// Must be called before the socket is closed
+void sockEvtsUnregister(SocketEvents &evts)
+{
+	SocketReactor *pReactor = (SocketReactor *)evts.pReactor;
+
+	if (!pReactor)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pReactor->mtx);
+#endif
+	::epoll_ctl(pReactor->fdEpoll, EPOLL_CTL_DEL, evts.fd, NULL);
+
+	pReactor->evtsByFd[evts.fd] = NULL;
+	--pReactor->numRegistered;
+
+	evts.pReactor = NULL;
+	evts.fd = INVALID_SOCKET;
+	evts.pending = 0;
+}
+
+// Return: Pending events. Polls if needed
+uint32_t sockEvtsGet(SocketEvents &evts)
+{
+	SocketReactor *pReactor = (SocketReactor *)evts.pReactor;
+	bool pollNeeded;
+
+	if (!pReactor)
+		return 0;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(pReactor->mtx);
+#endif
+		if (evts.pending)
+			return evts.pending;
+
+		pollNeeded = evts.gen == pReactor->gen;
+		evts.gen = pReactor->gen;
+	}
+
+	if (!pollNeeded)
+		return 0;
+
+	reactorPoll(pReactor, 0);
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pReactor->mtx);
+#endif
+	evts.gen = pReactor->gen;
+
+	return evts.pending;
+}
+
+void sockEvtsClear(SocketEvents &evts, uint32_t bits)
+{
+	SocketReactor *pReactor = (SocketReactor *)evts.pReactor;
+
+	if (!pReactor)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pReactor->mtx);
+#endif
+	evts.pending &= ~bits;
+}
+
+#else
+
+bool sockEvtsRegister(SocketEvents &evts, SOCKET fd, uint32_t interest)
+{
+	(void)evts;
+	(void)fd;
+	(void)interest;
+	return false;
+}
+
+bool sockEvtsInterestSet(SocketEvents &evts, uint32_t interest)
+{
+	(void)evts;
+	(void)interest;
+	return false;
+}
+
+void sockEvtsUnregister(SocketEvents &evts)
+{
+	(void)evts;
+}
+
+uint32_t sockEvtsGet(SocketEvents &evts)
+{
+	(void)evts;
+	return 0;
+}
+
+void sockEvtsClear(SocketEvents &evts, uint32_t bits)
+{
+	(void)evts;
+	(void)bits;
+}
+
+#endif
+
@@ -0,0 +1,110 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef SOCKET_EVENTS_H
+#define SOCKET_EVENTS_H
+
+#include "Processing.h"
+
+#ifndef CONFIG_PROC_HAVE_EPOLL
+#if defined(__linux__)
+#define CONFIG_PROC_HAVE_EPOLL				1
+#else
+#define CONFIG_PROC_HAVE_EPOLL				0
+#endif
+#endif
+
+#ifndef _WIN32
+#ifndef SOCKET
+#define SOCKET int
+#define INVALID_SOCKET -1
+#endif
+#else
+#include <winsock2.h>
+#endif
+
+/*
+  What are socket events?
+  - Every driver (thread) has its own epoll instance
+    - Sockets are registered by their owning process
+    - Readiness is collected into the SocketEvents of the socket
+  - Polling
+    - Once per tick: The first socket which has seen the last
+      poll already and has no pending events triggers the next poll
+    - Idle sockets therefore cost no syscall
+  - Internal drivers with registered sockets wait on their epoll
+    instance instead of sleeping. Events wake the driver immediately
+  - Without epoll every call fails and the processes
+    fall back to polling their sockets
+*/
+
+enum SocketEventBits
+{
+	SockEvtRead = 1,
+	SockEvtWrite = 2,
+	SockEvtHup = 4,
+	SockEvtErr = 8,
+};
+
+struct SocketEvents
+{
+	SocketEvents()
+		: pReactor(NULL)
+		, fd(INVALID_SOCKET)
+		, interest(0)
+		, pending(0)
+		, gen(0)
+	{}
+
+	void *pReactor;
+	SOCKET fd;
+	uint32_t interest;
+	uint32_t pending;
+	uint32_t gen;
+};
+
+/*
+ * Naming of functions:  objectVerb()
+ * Example:              sockEvtsRegister()
+ */
+
+bool sockEvtsRegister(SocketEvents &evts, SOCKET fd, uint32_t interest = SockEvtRead);
+bool sockEvtsInterestSet(SocketEvents &evts, uint32_t interest);
+void sockEvtsUnregister(SocketEvents &evts);
+uint32_t sockEvtsGet(SocketEvents &evts);
+void sockEvtsClear(SocketEvents &evts, uint32_t bits);
+
+inline bool sockEvtsRegistered(const SocketEvents &evts)
+{
+	return evts.pReactor;
+}
+
+#endif
+
@@ -0,0 +1,589 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <cstring>
+#include <cstdlib>
+
+#include "SocketRing.h"
+
+#if CONFIG_PROC_HAVE_IO_URING
+#include <vector>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+using namespace std;
+
+#if CONFIG_PROC_HAVE_IO_URING
+
+/* Literature
+ * - https://man7.org/linux/man-pages/man7/io_uring.7.html
+ * - https://man7.org/linux/man-pages/man2/io_uring_setup.2.html
+ * - https://man7.org/linux/man-pages/man2/io_uring_enter.2.html
+ * - https://man7.org/linux/man-pages/man3/io_uring_prep_recv_multishot.3.html
+ * - https://man7.org/linux/man-pages/man3/io_uring_register_buf_ring.3.html
+ * - https://man7.org/linux/man-pages/man3/io_uring_get_probe.3.html
+ * - https://kernel.dk/io_uring.pdf
+ */
+
+const unsigned cNumEntriesSq = 256;
+const uint64_t cUserDataCancel = ~0ULL;
+const uint16_t cIdBufGroup = 0;
+const uint32_t cNumBufs = CONFIG_PROC_IO_URING_NUM_BUFFERS;
+const uint32_t cSizeBuf = CONFIG_PROC_IO_URING_SIZE_BUFFER;
+const size_t cNumBufsSocketMax = PMAX(CONFIG_PROC_IO_URING_NUM_BUFFERS_SOCKET, 2);
+const unsigned cNumOpsProbe = 256;
+
+struct SocketRing
+{
+	SocketRing();
+	~SocketRing();
+
+	bool ok;
+	int fd;
+
+	// submission queue
+	void *pRings;
+	size_t sizeRings;
+	unsigned *pSqHead;
+	unsigned *pSqTail;
+	unsigned *pSqArray;
+	unsigned sqMask;
+	unsigned sqEntries;
+	unsigned sqTail;
+	unsigned numSqPending;
+	struct io_uring_sqe *pSqes;
+	size_t sizeSqes;
+
+	// completion queue
+	unsigned *pCqHead;
+	unsigned *pCqTail;
+	unsigned cqMask;
+	struct io_uring_cqe *pCqes;
+
+	// provided buffers
+	struct io_uring_buf_ring *pBufRing;
+	size_t sizeBufRing;
+	char *pBufs;
+	uint16_t bufTail;
+
+	uint32_t idNext;
+	// Completions are assigned by file descriptor and registration ID.
+	// Completions of unregistered sockets are therefore dropped
+	vector<SocketRecv *> recvByFd;
+	SocketEvents evts;
+#if CONFIG_PROC_HAVE_DRIVERS
+	mutex mtx;
+#endif
+};
+
+static thread_local SocketRing ringThread;
+
+// Multishot receive came with Linux 6.0. So did IORING_SETUP_SINGLE_ISSUER
+static bool multishotSupported()
+{
+#ifdef IORING_SETUP_SINGLE_ISSUER
+	struct io_uring_params params;
+	int fd;
+
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_SINGLE_ISSUER;
+
+	fd = (int)::syscall(__NR_io_uring_setup, 1, &params);
+	if (fd < 0)
+		return false;
+
+	::close(fd);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+static bool opsSupported(int fd)
+{
+	struct io_uring_probe *pProbe;
+	size_t sizeProbe;
+	bool ok = false;
+	int res;
+
+	sizeProbe = sizeof(*pProbe) + cNumOpsProbe * sizeof(struct io_uring_probe_op);
+
+	pProbe = (struct io_uring_probe *)calloc(1, sizeProbe);
+	if (!pProbe)
+		return false;
+
+	res = (int)::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, pProbe, cNumOpsProbe);
+	if (!res)
+	{
+		// Member ops has an offset in C++ due to __DECLARE_FLEX_ARRAY
+		struct io_uring_probe_op *pOps = (struct io_uring_probe_op *)(pProbe + 1);
+
+		ok = pProbe->last_op >= IORING_OP_RECV &&
+			pProbe->last_op >= IORING_OP_ASYNC_CANCEL &&
+			(pOps[IORING_OP_RECV].flags & IO_URING_OP_SUPPORTED) &&
+			(pOps[IORING_OP_ASYNC_CANCEL].flags & IO_URING_OP_SUPPORTED);
+	}
+
+	free(pProbe);
+
+	return ok;
+}
+
+static void bufRecycle(SocketRing *pRing, uint16_t idBuf)
+{
+	struct io_uring_buf *pBuf;
+
+	// Member bufs has an offset in C++ due to __DECLARE_FLEX_ARRAY
+	pBuf = (struct io_uring_buf *)pRing->pBufRing + (pRing->bufTail & (cNumBufs - 1));
+	pBuf->addr = (uint64_t)(uintptr_t)(pRing->pBufs + (size_t)idBuf * cSizeBuf);
+	pBuf->len = cSizeBuf;
+	pBuf->bid = idBuf;
+
+	++pRing->bufTail;
+}
+
+static void bufsPublish(SocketRing *pRing)
+{
+	__atomic_store_n(&pRing->pBufRing->tail, pRing->bufTail, __ATOMIC_RELEASE);
+}
+
+SocketRing::SocketRing()
+	: ok(false)
+	, fd(-1)
+	, pRings(MAP_FAILED)
+	, sizeRings(0)
+	, pSqHead(NULL)
+	, pSqTail(NULL)
+	, pSqArray(NULL)
+	, sqMask(0)
+	, sqEntries(0)
+	, sqTail(0)
+	, numSqPending(0)
+	, pSqes((struct io_uring_sqe *)MAP_FAILED)
+	, sizeSqes(0)
+	, pCqHead(NULL)
+	, pCqTail(NULL)
+	, cqMask(0)
+	, pCqes(NULL)
+	, pBufRing((struct io_uring_buf_ring *)MAP_FAILED)
+	, sizeBufRing(0)
+	, pBufs(NULL)
+	, bufTail(0)
+	, idNext(1)
+	, recvByFd()
+	, evts()
+{
+	struct io_uring_params params;
+	struct io_uring_buf_reg reg;
+	size_t sizeSq, sizeCq;
+	char *pBase;
+	int res;
+
+	if (!multishotSupported())
+		return;
+
+	memset(&params, 0, sizeof(params));
+
+	fd = (int)::syscall(__NR_io_uring_setup, cNumEntriesSq, &params);
+	if (fd < 0)
+		return;
+
+	if (!opsSupported(fd))
+		return;
+
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+		return;
+
+	sizeSq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	sizeCq = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	sizeRings = PMAX(sizeSq, sizeCq);
+
+	pRings = ::mmap(NULL, sizeRings, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (pRings == MAP_FAILED)
+		return;
+
+	sizeSqes = params.sq_entries * sizeof(struct io_uring_sqe);
+	pSqes = (struct io_uring_sqe *)::mmap(NULL, sizeSqes, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (pSqes == MAP_FAILED)
+		return;
+
+	pBase = (char *)pRings;
+
+	pSqHead = (unsigned *)(pBase + params.sq_off.head);
+	pSqTail = (unsigned *)(pBase + params.sq_off.tail);
+	pSqArray = (unsigned *)(pBase + params.sq_off.array);
+	sqMask = *(unsigned *)(pBase + params.sq_off.ring_mask);
+	sqEntries = params.sq_entries;
+	sqTail = *pSqTail;
+
+	pCqHead = (unsigned *)(pBase + params.cq_off.head);
+	pCqTail = (unsigned *)(pBase + params.cq_off.tail);
+	cqMask = *(unsigned *)(pBase + params.cq_off.ring_mask);
+	pCqes = (struct io_uring_cqe *)(pBase + params.cq_off.cqes);
+
+	// provided buffers
+	sizeBufRing = cNumBufs * sizeof(struct io_uring_buf);
+	pBufRing = (struct io_uring_buf_ring *)::mmap(NULL, sizeBufRing,
+				PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	if (pBufRing == MAP_FAILED)
+		return;
+
+	pBufs = (char *)malloc((size_t)cNumBufs * cSizeBuf);
+	if (!pBufs)
+		return;
+
+	// Pages are pinned by the kernel. Touch them before registering
+	memset(pBufRing, 0, sizeBufRing);
+
+	for (uint32_t idBuf = 0; idBuf < cNumBufs; ++idBuf)
+		bufRecycle(this, (uint16_t)idBuf);
+	bufsPublish(this);
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t)(uintptr_t)pBufRing;
+	reg.ring_entries = cNumBufs;
+	reg.bgid = cIdBufGroup;
+
+	res = (int)::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg, 1);
+	if (res)
+		return;
+
+	// Completions wake the driver
+	sockEvtsRegister(evts, fd);
+
+	ok = true;
+}
+
+SocketRing::~SocketRing()
+{
+	sockEvtsUnregister(evts);
+
+	// Kernel may still use the buffers. Close first
+	if (fd >= 0)
+		::close(fd);
+
+	if (pSqes != MAP_FAILED)
+		::munmap(pSqes, sizeSqes);
+
+	if (pRings != MAP_FAILED)
+		::munmap(pRings, sizeRings);
+
+	if (pBufRing != MAP_FAILED)
+		::munmap(pBufRing, sizeBufRing);
+
+	free(pBufs);
+}
+
+static void ringSubmit(SocketRing *pRing)
+{
+	if (!pRing->numSqPending)
+		return;
+
+	__atomic_store_n(pRing->pSqTail, pRing->sqTail, __ATOMIC_RELEASE);
+
+	::syscall(__NR_io_uring_enter, pRing->fd, pRing->numSqPending, 0, 0, NULL, 0);
+
+	pRing->numSqPending = 0;
+}
+
+static struct io_uring_sqe *sqeGet(SocketRing *pRing)
+{
+	unsigned head = __atomic_load_n(pRing->pSqHead, __ATOMIC_ACQUIRE);
+	unsigned idx;
+
+	if (pRing->sqTail - head >= pRing->sqEntries)
+	{
+		ringSubmit(pRing);
+
+		head = __atomic_load_n(pRing->pSqHead, __ATOMIC_ACQUIRE);
+		if (pRing->sqTail - head >= pRing->sqEntries)
+			return NULL;
+	}
+
+	idx = pRing->sqTail & pRing->sqMask;
+	pRing->pSqArray[idx] = idx;
+
+	++pRing->sqTail;
+	++pRing->numSqPending;
+
+	struct io_uring_sqe *pSqe = &pRing->pSqes[idx];
+
+	memset(pSqe, 0, sizeof(*pSqe));
+
+	return pSqe;
+}
+
+static uint64_t userDataGet(const SocketRecv &recv)
+{
+	return ((uint64_t)recv.id << 32) | (uint32_t)recv.fd;
+}
+
+static void recvArm(SocketRing *pRing, SocketRecv &recv)
+{
+	struct io_uring_sqe *pSqe = sqeGet(pRing);
+	if (!pSqe)
+		return;
+
+	pSqe->opcode = IORING_OP_RECV;
+	pSqe->fd = recv.fd;
+	pSqe->ioprio = IORING_RECV_MULTISHOT;
+	pSqe->flags = IOSQE_BUFFER_SELECT;
+	pSqe->buf_group = cIdBufGroup;
+	pSqe->user_data = userDataGet(recv);
+
+	recv.armed = true;
+}
+
+static void recvCancel(SocketRing *pRing, const SocketRecv &recv)
+{
+	struct io_uring_sqe *pSqe = sqeGet(pRing);
+	if (!pSqe)
+		return;
+
+	pSqe->opcode = IORING_OP_ASYNC_CANCEL;
+	pSqe->fd = -1;
+	pSqe->addr = userDataGet(recv);
+	pSqe->user_data = cUserDataCancel;
+}
+
+static void cqeHandle(SocketRing *pRing, const struct io_uring_cqe *pCqe)
+{
+	if (pCqe->user_data == cUserDataCancel)
+		return;
+
+	int fd = (int)(uint32_t)pCqe->user_data;
+	uint32_t id = (uint32_t)(pCqe->user_data >> 32);
+	bool hasBuf = pCqe->flags & IORING_CQE_F_BUFFER;
+	uint16_t idBuf = (uint16_t)(pCqe->flags >> IORING_CQE_BUFFER_SHIFT);
+	SocketRecv *pRecv = NULL;
+
+	if (fd >= 0 && (size_t)fd < pRing->recvByFd.size())
+		pRecv = pRing->recvByFd[fd];
+
+	if (!pRecv || pRecv->id != id)
+	{
+		if (hasBuf)
+			bufRecycle(pRing, idBuf);
+		return;
+	}
+
+	if (!(pCqe->flags & IORING_CQE_F_MORE))
+	{
+		pRecv->armed = false;
+		pRecv->stopping = false;
+	}
+
+	if (pCqe->res > 0 && hasBuf)
+	{
+		pRecv->chunks.push_back({ idBuf, 0, (uint32_t)pCqe->res });
+
+		// Data stays in the socket. Armed again on the read
+		if (pRecv->armed && !pRecv->stopping &&
+				pRecv->chunks.size() >= cNumBufsSocketMax)
+		{
+			recvCancel(pRing, *pRecv);
+			pRecv->stopping = true;
+		}
+
+		return;
+	}
+
+	if (hasBuf)
+		bufRecycle(pRing, idBuf);
+
+	// Out of buffers: Armed again on the next read
+	if (pCqe->res == -ENOBUFS || pCqe->res == -ECANCELED)
+		return;
+
+	pRecv->res = pCqe->res;
+}
+
+static void ringReap(SocketRing *pRing)
+{
+	unsigned head = *pRing->pCqHead;
+	unsigned tail = __atomic_load_n(pRing->pCqTail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; ++head)
+		cqeHandle(pRing, &pRing->pCqes[head & pRing->cqMask]);
+
+	__atomic_store_n(pRing->pCqHead, head, __ATOMIC_RELEASE);
+
+	bufsPublish(pRing);
+}
+
+bool sockRingRegister(SocketRecv &recv, SOCKET fd)
+{
+	SocketRing *pRing = &ringThread;
+
+	if (!pRing->ok || recv.pRing || fd < 0)
+		return false;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pRing->mtx);
+#endif
+	if ((size_t)fd >= pRing->recvByFd.size())
+		pRing->recvByFd.resize(fd + 1, NULL);
+
+	recv.pRing = pRing;
+	recv.fd = fd;
+	recv.id = pRing->idNext++;
+	recv.res = 1;
+	recv.stopping = false;
+	recv.chunks.clear();
+
+	pRing->recvByFd[fd] = &recv;
+
+	recvArm(pRing, recv);
+	ringSubmit(pRing);
+
+	return true;
+}
+
+// Must be called before the socket is closed
+void sockRingUnregister(SocketRecv &recv)
+{
+	SocketRing *pRing = (SocketRing *)recv.pRing;
+
+	if (!pRing)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pRing->mtx);
+#endif
+	recvCancel(pRing, recv);
+	ringSubmit(pRing);
+
+	for (const SocketRecvChunk &chunk : recv.chunks)
+		bufRecycle(pRing, chunk.idBuf);
+	bufsPublish(pRing);
+
+	pRing->recvByFd[recv.fd] = NULL;
+
+	recv.chunks.clear();
+	recv.pRing = NULL;
+	recv.fd = INVALID_SOCKET;
+	recv.armed = false;
+	recv.stopping = false;
+}
+
+ssize_t sockRingRead(SocketRecv &recv, void *pBuf, size_t lenReq)
+{
+	SocketRing *pRing = (SocketRing *)recv.pRing;
+
+	if (!pRing)
+		return -1;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(pRing->mtx);
+#endif
+	ringReap(pRing);
+
+	// Stopped sockets continue after half of their buffers are read
+	if (!recv.armed && recv.res > 0 &&
+			recv.chunks.size() <= cNumBufsSocketMax / 2)
+		recvArm(pRing, recv);
+
+	ringSubmit(pRing);
+
+	size_t numBytes = 0;
+
+	if (!pBuf || !lenReq)
+	{
+		for (const SocketRecvChunk &chunk : recv.chunks)
+			numBytes += chunk.len;
+
+		if (numBytes)
+			return numBytes;
+
+		return recv.res > 0 ? 0 : -1;
+	}
+
+	char *pDst = (char *)pBuf;
+	size_t lenCopy;
+
+	while (lenReq && recv.chunks.size())
+	{
+		SocketRecvChunk &chunk = recv.chunks.front();
+
+		lenCopy = PMIN((size_t)chunk.len, lenReq);
+
+		memcpy(pDst, pRing->pBufs + (size_t)chunk.idBuf * cSizeBuf + chunk.offset, lenCopy);
+
+		pDst += lenCopy;
+		lenReq -= lenCopy;
+		numBytes += lenCopy;
+
+		chunk.offset += lenCopy;
+		chunk.len -= lenCopy;
+
+		if (chunk.len)
+			break;
+
+		bufRecycle(pRing, chunk.idBuf);
+		recv.chunks.pop_front();
+	}
+
+	bufsPublish(pRing);
+
+	if (numBytes)
+		return numBytes;
+
+	return recv.res > 0 ? 0 : -1;
+}
+
+#else
+
+bool sockRingRegister(SocketRecv &recv, SOCKET fd)
+{
+	(void)recv;
+	(void)fd;
+	return false;
+}
+
+void sockRingUnregister(SocketRecv &recv)
+{
+	(void)recv;
+}
+
+ssize_t sockRingRead(SocketRecv &recv, void *pBuf, size_t lenReq)
+{
+	(void)recv;
+	(void)pBuf;
+	(void)lenReq;
+	return -1;
+}
+
+#endif
+
@@ -0,0 +1,121 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef SOCKET_RING_H
+#define SOCKET_RING_H
+
+#include <deque>
+
+#include "SocketEvents.h"
+
+// Linux 6.0 or newer. Kconfig PROC_HAVE_IO_URING. Probed at runtime
+#ifndef CONFIG_PROC_HAVE_IO_URING
+#define CONFIG_PROC_HAVE_IO_URING				0
+#endif
+
+// Power of two
+#ifndef CONFIG_PROC_IO_URING_NUM_BUFFERS
+#define CONFIG_PROC_IO_URING_NUM_BUFFERS		256
+#endif
+
+#ifndef CONFIG_PROC_IO_URING_SIZE_BUFFER
+#define CONFIG_PROC_IO_URING_SIZE_BUFFER		4096
+#endif
+
+// Buffers held by a single socket before its receive is stopped
+#ifndef CONFIG_PROC_IO_URING_NUM_BUFFERS_SOCKET
+#define CONFIG_PROC_IO_URING_NUM_BUFFERS_SOCKET	(CONFIG_PROC_IO_URING_NUM_BUFFERS / 8)
+#endif
+
+/*
+  What is the socket ring?
+  - Receive backend using io_uring. Every driver (thread) has its own ring
+  - One multishot receive per socket
+    - Armed once. Data is delivered without a syscall per read
+    - Buffers are provided to the kernel by a registered buffer ring
+    - A socket holding too many buffers is stopped until the
+      application has read half of them. A socket which isn't read
+      therefore can't starve the other sockets of the driver
+  - Submissions are collected and flushed once per read call
+  - The ring file descriptor is registered in the socket events
+    of the driver. Completions therefore wake the driver
+  - Support is probed on setup: Required operations by
+    IORING_REGISTER_PROBE, multishot receive by a setup flag of
+    the same kernel release
+  - If the ring can't be set up, every registration fails
+    and the sockets fall back to the socket events
+*/
+
+struct SocketRecvChunk
+{
+	uint16_t idBuf;
+	uint32_t offset;
+	uint32_t len;
+};
+
+struct SocketRecv
+{
+	SocketRecv()
+		: pRing(NULL)
+		, fd(INVALID_SOCKET)
+		, id(0)
+		, armed(false)
+		, stopping(false)
+		, res(1)
+		, chunks()
+	{}
+
+	void *pRing;
+	SOCKET fd;
+	uint32_t id;
+	bool armed;
+	bool stopping;
+	// 1: Open, 0: Closed by peer, < 0: -errno
+	int res;
+	std::deque<SocketRecvChunk> chunks;
+};
+
+/*
+ * Naming of functions:  objectVerb()
+ * Example:              sockRingRegister()
+ */
+
+bool sockRingRegister(SocketRecv &recv, SOCKET fd);
+void sockRingUnregister(SocketRecv &recv);
+// Return: Bytes read. pBuf = NULL: Bytes available. -1: Connection ended, see recv.res
+ssize_t sockRingRead(SocketRecv &recv, void *pBuf, size_t lenReq);
+
+inline bool sockRingRegistered(const SocketRecv &recv)
+{
+	return recv.pRing;
+}
+
+#endif
+
@@ -74,7 +74,7 @@ dProcessStateStr(ProcState);
 #define dGenKeyStateEnum(s) s,
 dProcessStateEnum(KeyState);
 
-#if 1
+#if CONFIG_PROC_LOG_LEVEL_MAX >= 1
 #define dGenKeyStateString(s) #s,
 dProcessStateStr(KeyState);
 #endif
@@ -152,12 +152,36 @@ enum KeyExtensions
 const string cWelcomeMsg = "\r\n" dPackageName "\r\n" \
 			"System Terminal\r\n\r\n" \
 			"type 'help' or just 'h' for a list of available commands\r\n\r\n";
+const SendBuf cSeqsTelnetInit[] =
+{
+	// IAC WILL ECHO
+	dSendBufStr("\xFF\xFB\x01"),
+
+	// IAC WILL SUPPRESS_GO_AHEAD
+	dSendBufStr("\xFF\xFB\x03"),
+
+	// IAC WONT LINEMODE
+	dSendBufStr("\xFF\xFC\x22"),
+
+	// Hide cursor
+	dSendBufStr("\033[?25l"),
+
+	// Alternative screen buffer
+	dSendBufStr("\033[?1049h"),
+
+	// Set terminal title
+	dSendBufStr("\033]2;SystemCommanding()\a"),
+
+	// Clear screen
+	dSendBufStr("\033[2J\033[H"),
+};
 const string cSeqCtrlC = "\xff\xf4\xff\xfd\x06";
 const size_t cLenSeqCtrlC = cSeqCtrlC.size();
 
 const uint32_t cTmoCmdAuto = 200;
 const int cSizeCmdIdMax = 16;
 const long int cLenHexDumpStd = 16;
+const long int cNumConnStatsStd = 4;
 
 // --------------------
 
@@ -173,7 +197,7 @@ static mutex mtxCmds;
 
 SystemCommanding::SystemCommanding(SOCKET fd)
 	: Processing("SystemCommanding")
-	, mSocketFd(fd)
+	, mPeer()
 	, mpTrans(NULL)
 	, mStateKey(StKeyMain)
 	, mStartMs(0)
@@ -190,6 +214,7 @@ SystemCommanding::SystemCommanding(SOCKET fd)
 	, mIdxColLineEnd(0)
 {
 	mBufOut[0] = 0;
+	mPeer.fd = fd;
 
 	mState = StStart;
 
@@ -197,6 +222,13 @@ SystemCommanding::SystemCommanding(SOCKET fd)
 		mCmdInBuf[i][0] = 0;
 }
 
+// Peer address and source are handed over to the connection
+SystemCommanding::SystemCommanding(const TcpPeer &peer)
+	: SystemCommanding(peer.fd)
+{
+	mPeer = peer;
+}
+
 /* member functions */
 
 Success SystemCommanding::process()
@@ -206,7 +238,6 @@ Success SystemCommanding::process()
 	Success success;
 	//bool ok;
 	//int res;
-	string msg;
 #if 0
 	dStateTrace;
 #endif
@@ -214,10 +245,10 @@ Success SystemCommanding::process()
 	{
 	case StStart:
 
-		if (mSocketFd == INVALID_SOCKET)
+		if (mPeer.fd == INVALID_SOCKET)
 			return procErrLog(-1, "socket file descriptor not set");
 
-		mpTrans = TcpTransfering::create(mSocketFd);
+		mpTrans = TcpTransfering::create(mPeer);
 		if (!mpTrans)
 			return procErrLog(-1, "could not create process");
 
@@ -240,6 +271,8 @@ Success SystemCommanding::process()
 
 		if (mModeAuto)
 		{
+			mpTrans->frameDecoderSet(Transfering::frameLineDecode, cSizeBufCmdIn - 1);
+
 			mStartMs = curTimeMs;
 			mState = StCmdAutoReceiveWait;
 			break;
@@ -251,40 +284,19 @@ Success SystemCommanding::process()
 		break;
 	case StCmdAutoReceiveWait:
 
+		success = autoCommandReceive(diffMs > cTmoCmdAuto);
+		if (success != Pending)
+			return success;
+
 		if (diffMs > cTmoCmdAuto)
 			return procErrLog(-1, "timeout receiving command");
 
-		success = autoCommandReceive();
-		if (success == Pending)
-			break;
-
-		return success;
+		break;
 
 		break;
 	case StTelnetInit:
 
-		// IAC WILL ECHO
-		msg += "\xFF\xFB\x01";
-
-		// IAC WILL SUPPRESS_GO_AHEAD
-		msg += "\xFF\xFB\x03";
-
-		// IAC WONT LINEMODE
-		msg += "\xFF\xFC\x22";
-
-		// Hide cursor
-		msg += "\033[?25l";
-
-		// Alternative screen buffer
-		msg += "\033[?1049h";
-
-		// Set terminal title
-		msg += "\033]2;SystemCommanding()\a";
-
-		// Clear screen
-		msg += "\033[2J\033[H";
-
-		mpTrans->send(msg.c_str(), msg.size());
+		mpTrans->send(cSeqsTelnetInit, sizeof(cSeqsTelnetInit) / sizeof(cSeqsTelnetInit[0]));
 
 		mTermChanged = true;
 
@@ -349,36 +361,52 @@ Success SystemCommanding::shutdown()
 	return Positive;
 }
 
-Success SystemCommanding::autoCommandReceive()
+/*
+ * Commands are terminated by a newline. Clients which send
+ * the command without newline are served as well: Data received
+ * until the timeout or the end of the connection is the command
+ */
+Success SystemCommanding::autoCommandReceive(bool tmo)
 {
-	ssize_t lenReq, lenDone;
 	char *pEdit = mCmdInBuf[mIdxLineEdit];
+	RecvFrame frame;
+	Success success;
 
 	*pEdit = 0;
 
-	lenReq = cSizeBufCmdIn;
-
-	lenDone = mpTrans->read(mCmdInBuf[0], lenReq);
-	if (!lenDone)
+	// Line without newline
+	success = mpTrans->frameRead(frame);
+	if (success == Pending && !tmo)
 		return Pending;
 
-	if (lenDone < 0)
-		return procErrLog(-1, "could not receive command");
+	if (success != Positive)
+	{
+		if (!mpTrans->recvPending())
+		{
+			if (success == Pending)
+				return Pending;
 
-	pEdit[lenDone] = 0;
+			return procErrLog(-1, "could not receive command");
+		}
+
+		// Everything received so far
+		mpTrans->frameDecoderSet(NULL);
 
-	// remove newline
+		success = mpTrans->frameRead(frame);
+		if (success != Positive)
+			return procErrLog(-1, "could not receive command");
 
-	if (pEdit[lenDone - 1] == '\n')
-		pEdit[--lenDone] = 0;
+		if (frame.len >= cSizeBufCmdIn)
+			return procErrLog(-1, "command too long");
+	}
 
-	if (pEdit[lenDone - 1] == '\r')
-		pEdit[--lenDone] = 0;
+	memcpy(pEdit, frame.pData, frame.len);
+	pEdit[frame.len] = 0;
 #if 0
-	procInfLog("auto bytes received: %d", lenDone);
+	procInfLog("auto bytes received: %zu", frame.len);
 	procInfLog("auto command received: %s", pEdit);
 
-	for (ssize_t i = 0; i < lenDone; ++i)
+	for (size_t i = 0; i < frame.len; ++i)
 		procInfLog("byte: %3u %02x '%c'", pEdit[i], pEdit[i], pEdit[i]);
 #endif
 	commandExecute();
@@ -388,27 +416,25 @@ Success SystemCommanding::autoCommandReceive()
 
 void SystemCommanding::dataReceive()
 {
-	ssize_t lenReq, lenPlanned, lenDone;
-	char buf[8];
+	const char *buf;
+	ssize_t lenDone;
+	RecvFrame frame;
 	Success success;
 	uint16_t key;
 
-	buf[0] = 0;
-
-	lenReq = sizeof(buf) - 1;
-	lenPlanned = lenReq;
-
-	lenDone = mpTrans->read(buf, lenPlanned);
-	if (!lenDone)
+	// Everything received so far
+	success = mpTrans->frameRead(frame);
+	if (success == Pending)
 		return;
 
-	if (lenDone < 0)
+	if (success != Positive)
 	{
 		mDone = true;
 		return;
 	}
 
-	buf[lenDone] = 0;
+	buf = (const char *)frame.pData;
+	lenDone = frame.len;
 
 	//procInfLog("bytes received: %d", lenDone);
 
@@ -1125,6 +1151,10 @@ void SystemCommanding::globalInit()
 		cmdHexDump,
 		"", "Hex dump. Usage: hd <addr> [len=16]",
 		cInternalCmdCls);
+	cmdReg("tcpStats",
+		cmdTcpStats,
+		"", "Connection statistics. Usage: tcpStats [num=4]",
+		cInternalCmdCls);
 #if 0
 	cmdReg("broadcast",
 		messageBroadcast,
@@ -1517,6 +1547,22 @@ void SystemCommanding::cmdHexDump(char *pArgs, char *pBuf, char *pBufEnd)
 	hexDumpPrint(pBuf, pBufEnd, pData, len, NULL, 8);
 }
 
+void SystemCommanding::cmdTcpStats(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	long int numConn = cNumConnStatsStd;
+
+	if (pArgs)
+		numConn = strtol(pArgs, NULL, 0);
+
+	if (numConn < 0)
+	{
+		dInfo("Number must not be negative\n");
+		return;
+	}
+
+	TcpTransfering::statsListStr(pBuf, pBufEnd, numConn);
+}
+
 size_t SystemCommanding::hexDumpPrint(char *pBuf, char *pBufEnd,
 			const void *pData, size_t len,
 			const char *pName, size_t colWidth)
@@ -90,6 +90,11 @@ public:
 		return new (std::nothrow) SystemCommanding(fd);
 	}
 
+	static SystemCommanding *create(const TcpPeer &peer)
+	{
+		return new (std::nothrow) SystemCommanding(peer);
+	}
+
 	void modeAutoSet() { mModeAuto = true; }
 
 protected:
@@ -100,6 +105,7 @@ private:
 
 	SystemCommanding() = delete;
 	SystemCommanding(SOCKET fd);
+	SystemCommanding(const TcpPeer &peer);
 	SystemCommanding(const SystemCommanding &) = delete;
 	SystemCommanding &operator=(const SystemCommanding &) = delete;
 
@@ -112,7 +118,7 @@ private:
 	Success process();
 	Success shutdown();
 
-	Success autoCommandReceive();
+	Success autoCommandReceive(bool tmo);
 	void dataReceive();
 	void tabProcess();
 	void cmdAutoComplete();
@@ -140,7 +146,7 @@ private:
 	Success ansiFilter(uint8_t key, uint16_t *pKeyOut);
 
 	/* member variables */
-	SOCKET mSocketFd;
+	TcpPeer mPeer;
 	TcpTransfering *mpTrans;
 	uint32_t mStateKey;
 	uint32_t mStartMs;
@@ -162,6 +168,7 @@ private:
 	static uint32_t millis();
 	static void cmdHelpPrint(char *pArgs, char *pBuf, char *pBufEnd);
 	static void cmdHexDump(char *pArgs, char *pBuf, char *pBufEnd);
+	static void cmdTcpStats(char *pArgs, char *pBuf, char *pBufEnd);
 	static size_t hexDumpPrint(char *pBuf, char *pBufEnd,
 					const void *pData, size_t len,
 					const char *pName = NULL, size_t colWidth = 0x10);
@@ -39,10 +39,7 @@ typedef list<struct SystemDebuggingPeer>::iterator PeerIter;
 bool SystemDebugging::procTreeDetailed = true;
 bool SystemDebugging::procTreeColored = true;
 
-queue<string> SystemDebugging::qLogEntries;
-#if CONFIG_PROC_HAVE_DRIVERS
-static mutex mtxLogEntries;
-#endif
+int SystemDebugging::idSinkLog = -1;
 int SystemDebugging::levelLog = 3;
 
 const size_t SystemDebugging::maxPeers = 100;
@@ -51,6 +48,10 @@ const string cSeqCtrlC = "\xff\xf4\xff\xfd\x06";
 const size_t cLenSeqCtrlC = cSeqCtrlC.size();
 
 static char buffProcTree[8192];
+#if CONFIG_PROC_HAVE_LOG
+const size_t cSizeSinkLog = 16384;
+static char buffLogEntries[cSizeSinkLog];
+#endif
 
 SystemDebugging::SystemDebugging(Processing *pTreeRoot)
 	: Processing("SystemDebugging")
@@ -91,6 +92,7 @@ bool SystemDebugging::ready()
 void SystemDebugging::levelLogSet(int lvl)
 {
 	levelLog = lvl;
+	logSinkLevelSet(idSinkLog, lvl);
 }
 
 Success SystemDebugging::initialize()
@@ -141,9 +143,15 @@ Success SystemDebugging::initialize()
 	//cmdReg("colored", &SystemDebugging::procTreeColoredToggle, "", "toggle colored process tree output", cInternalCmdCls);
 	cmdReg("levelLog", &SystemDebugging::cmdLevelLogSet, "", "Set the log level for stdout", cInternalCmdCls);
 	cmdReg("levelLogSys", &SystemDebugging::cmdLevelLogSysSet, "", "Set the log level for socket", cInternalCmdCls);
-
-	entryLogCreateSet(SystemDebugging::entryLogCreate);
-
+	cmdReg("levelLogFile", &SystemDebugging::cmdLevelLogFileSet, "", "Override log level of file. Usage: levelLogFile [<file> [lvl]]", cInternalCmdCls);
+	cmdReg("levelLogProc", &SystemDebugging::cmdLevelLogProcSet, "", "Override log level of process. Usage: levelLogProc [<name> [lvl]]", cInternalCmdCls);
+#if CONFIG_PROC_HAVE_LOG
+	// Don't replace the sink of the application
+	if (idSinkLog < 0)
+		idSinkLog = logSinkBufferAdd(cSizeSinkLog, levelLog);
+	if (idSinkLog < 0)
+		return procErrLog(-1, "could not add log sink");
+#endif
 	return Positive;
 }
 
@@ -161,6 +169,9 @@ Success SystemDebugging::process()
 
 Success SystemDebugging::shutdown()
 {
+	logSinkRemove(idSinkLog);
+	idSinkLog = -1;
+
 	return Positive;
 }
 
@@ -176,7 +187,7 @@ void SystemDebugging::peerListUpdate()
 
 void SystemDebugging::commandAutoProcess()
 {
-	PipeEntry<SOCKET> peerFd;
+	PipeEntry<TcpPeer> peerFd;
 	SystemCommanding *pCmd;
 
 	while (1)
@@ -276,7 +287,7 @@ void SystemDebugging::peerCheck()
 
 void SystemDebugging::peerAdd(TcpListening *pListener, enum PeerType peerType, const char *pTypeDesc)
 {
-	PipeEntry<SOCKET> peerFd;
+	PipeEntry<TcpPeer> peerFd;
 	Processing *pProc = NULL;
 	struct SystemDebuggingPeer peer;
 
@@ -356,10 +367,11 @@ void SystemDebugging::processTreeSend()
 	//procDbgLog("process tree changed");
 	//procDbgLog("\n%s", procTree.c_str());
 
-	string msg("\033[2J\033[H");
-
-	msg += procTree;
-
+	SendBuf bufs[] =
+	{
+		dSendBufStr("\033[2J\033[H"),
+		{ procTree.c_str(), procTree.size() },
+	};
 	PeerIter iter;
 	struct SystemDebuggingPeer peer;
 	TcpTransfering *pTrans = NULL;
@@ -374,7 +386,7 @@ void SystemDebugging::processTreeSend()
 			continue;
 
 		if (peer.type == PeerProc)
-			pTrans->send(msg.c_str(), msg.size());
+			pTrans->send(bufs, sizeof(bufs) / sizeof(bufs[0]));
 	}
 
 	mProcTree = procTree;
@@ -386,29 +398,21 @@ void SystemDebugging::processTreeSend()
 #if CONFIG_PROC_HAVE_LOG
 void SystemDebugging::logEntriesSend()
 {
-	string msg;
 	PeerIter iter;
 	struct SystemDebuggingPeer peer;
 	TcpTransfering *pTrans = NULL;
+	size_t len;
+
+	// Counts of call sites which went quiet
+	logFlush();
 
 	while (1)
 	{
-		{
-#if CONFIG_PROC_HAVE_DRIVERS
-			Guard lock(mtxLogEntries);
-#endif
-			if (!qLogEntries.size())
-				break;
-
-			msg = qLogEntries.front();
-			qLogEntries.pop();
-		}
-
-		if (!msg.size())
+		// One chunk of entries per send
+		len = logSinkBufferRead(idSinkLog, buffLogEntries, sizeof(buffLogEntries));
+		if (!len)
 			break;
 
-		msg += "\r\n";
-
 		iter = mPeerList.begin();
 		while (iter != mPeerList.end())
 		{
@@ -419,7 +423,7 @@ void SystemDebugging::logEntriesSend()
 				continue;
 
 			if (peer.type == PeerLog)
-				pTrans->send(msg.c_str(), msg.size());
+				pTrans->send(buffLogEntries, len);
 		}
 	}
 }
@@ -428,6 +432,10 @@ void SystemDebugging::logEntriesSend()
 void SystemDebugging::processInfo(char *pBuf, char *pBufEnd)
 {
 	dInfo("Update period [ms]\t\t%d\n", (int)mUpdateMs);
+#if CONFIG_PROC_HAVE_LOG
+	dInfo("Log entries suppressed\t%u\n", (unsigned)logEntriesSuppressed());
+	dInfo("Log entries dropped\t\t%u\n", (unsigned)logSinkEntriesDropped(idSinkLog));
+#endif
 }
 
 /* static functions */
@@ -455,6 +463,77 @@ void SystemDebugging::cmdLevelLogSysSet(char *pArgs, char *pBuf, char *pBufEnd)
 	dInfo("System log level set to %d", lvl);
 }
 
+void SystemDebugging::cmdLevelLogFileSet(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	levelLogOverrideCmd(pArgs, pBuf, pBufEnd, false);
+}
+
+void SystemDebugging::cmdLevelLogProcSet(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	levelLogOverrideCmd(pArgs, pBuf, pBufEnd, true);
+}
+
+void SystemDebugging::levelLogOverrideCmd(char *pArgs, char *pBuf, char *pBufEnd, bool isProc)
+{
+	if (!pArgs)
+	{
+		pBuf += levelLogOverridesStr(pBuf, pBufEnd);
+		return;
+	}
+
+	const char *pName = pArgs;
+	char *pLvl, *pEnd;
+	int lvl = -1;
+	Success success;
+
+	pLvl = strchr(pArgs, ' ');
+	if (pLvl)
+	{
+		*pLvl++ = 0;
+		lvl = strtol(pLvl, &pEnd, 10);
+
+		if (pEnd == pLvl || *pEnd)
+		{
+			dInfo("Could not set log level override. Invalid level: %s", pLvl);
+			return;
+		}
+	}
+
+	if (isProc)
+		success = ::levelLogProcSet(pName, lvl);
+	else
+		success = ::levelLogFileSet(pName, lvl);
+
+	if (success == -1)
+	{
+		dInfo("Could not set log level override. No name given");
+		return;
+	}
+
+	if (success == -2)
+	{
+		dInfo("Could not set log level override. Name too long: %s", pName);
+		return;
+	}
+
+	if (success == -3)
+	{
+		dInfo("Could not set log level override. No free slot available");
+		return;
+	}
+
+	if (success != Positive)
+	{
+		dInfo("Could not set log level override. Log not available");
+		return;
+	}
+
+	if (lvl < 0)
+		dInfo("Log level override for %s removed", pName);
+	else
+		dInfo("Log level for %s set to %d", pName, lvl);
+}
+
 void SystemDebugging::procTreeDetailedToggle(char *pArgs, char *pBuf, char *pBufEnd)
 {
 	(void)pArgs;
@@ -475,26 +554,3 @@ void SystemDebugging::procTreeColoredToggle(char *pArgs, char *pBuf, char *pBufE
 #endif
 }
 
-void SystemDebugging::entryLogCreate(
-		const int severity,
-		const char *filename,
-		const char *function,
-		const int line,
-		const int16_t code,
-		const char *msg,
-		const size_t len)
-{
-#if CONFIG_PROC_HAVE_DRIVERS
-	Guard lock(mtxLogEntries);
-#endif
-	(void)filename;
-	(void)function;
-	(void)line;
-	(void)code;
-
-	if (severity > levelLog)
-		return;
-
-	qLogEntries.emplace(msg, len);
-}
-
@@ -125,21 +125,16 @@ private:
 	/* static functions */
 	static void cmdLevelLogSet(char *pArgs, char *pBuf, char *pBufEnd);
 	static void cmdLevelLogSysSet(char *pArgs, char *pBuf, char *pBufEnd);
+	static void cmdLevelLogFileSet(char *pArgs, char *pBuf, char *pBufEnd);
+	static void cmdLevelLogProcSet(char *pArgs, char *pBuf, char *pBufEnd);
+	static void levelLogOverrideCmd(char *pArgs, char *pBuf, char *pBufEnd, bool isProc);
 	static void procTreeDetailedToggle(char *pArgs, char *pBuf, char *pBufEnd);
 	static void procTreeColoredToggle(char *pArgs, char *pBuf, char *pBufEnd);
-	static void entryLogCreate(
-			const int severity,
-			const char *filename,
-			const char *function,
-			const int line,
-			const int16_t code,
-			const char *msg,
-			const size_t len);
 
 	/* static variables */
 	static bool procTreeDetailed;
 	static bool procTreeColored;
-	static std::queue<std::string> qLogEntries;
+	static int idSinkLog;
 	static int levelLog;
 
 	/* constants */
@@ -0,0 +1,343 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "TcpDispatching.h"
+// peerClose()
+#include "TcpListening.h"
+
+#define dForEach_ProcState(gen) \
+		gen(StStart) \
+		gen(StMain) \
+
+#define dGenProcStateEnum(s) s,
+dProcessStateEnum(ProcState);
+
+#if 0
+#define dGenProcStateString(s) #s,
+dProcessStateStr(ProcState);
+#endif
+
+static const char *DispatchStrategyString[] = {
+	"Round robin",
+	"Least connections",
+	"Peer hash",
+};
+
+using namespace std;
+
+TcpDispatching::TcpDispatching()
+	: Processing("TcpDispatching")
+	, mpPeers(NULL)
+	, mStrategy(DispatchRoundRobin)
+	, mWorkers()
+	, mIdxNext(0)
+	, mPeerHeld()
+	, mHeld(false)
+	, mSaturated(false)
+	, mConnDispatched(0)
+	, mBackpressure(0)
+	, mHashSpilled(0)
+{
+	mState = StStart;
+}
+
+/*
+ * Usually the queue of a listener: &pLst->ppPeerFd
+ */
+void TcpDispatching::sourceSet(Pipe<TcpPeer> *pPeers)
+{
+	mpPeers = pPeers;
+}
+
+/*
+ * DispatchRoundRobin  Workers in turn
+ * DispatchLeastConn   Worker with the fewest connections
+ * DispatchPeerHash    Same peer IP, same worker. Spills over
+ *                     to the next worker when saturated
+ */
+void TcpDispatching::strategySet(DispatchStrategy strategy)
+{
+	mStrategy = strategy;
+}
+
+/*
+ * A worker is saturated when numConnMax is reached
+ * or its queue is full
+ */
+TcpDispatchWorker *TcpDispatching::workerAdd(size_t numConnMax)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mMtxWorkers);
+#endif
+	mWorkers.emplace_back();
+
+	TcpDispatchWorker *pWorker = &mWorkers.back();
+	pWorker->numConnMax = numConnMax;
+
+	return pWorker;
+}
+
+// Called by the worker when a connection is finished
+void TcpDispatching::connRelease(TcpDispatchWorker *pWorker)
+{
+	if (!pWorker)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mMtxWorkers);
+#endif
+	if (pWorker->numConn)
+		--pWorker->numConn;
+}
+
+Success TcpDispatching::process()
+{
+	size_t numWorkers;
+#if 0
+	dStateTrace;
+#endif
+	switch (mState)
+	{
+	case StStart:
+
+		if (!mpPeers)
+			return procErrLog(-1, "source not set");
+
+		{
+#if CONFIG_PROC_HAVE_DRIVERS
+			Guard lock(mMtxWorkers);
+#endif
+			numWorkers = mWorkers.size();
+		}
+
+		if (!numWorkers)
+			return procErrLog(-1, "no workers added");
+
+		mState = StMain;
+
+		break;
+	case StMain:
+
+		return peersDispatch();
+
+	default:
+		break;
+	}
+
+	return Pending;
+}
+
+Success TcpDispatching::peersDispatch()
+{
+	TcpDispatchWorker *pWorker;
+	ssize_t res;
+
+	while (1)
+	{
+		if (!mHeld)
+		{
+			res = mpPeers->get(mPeerHeld);
+			if (res < 0)
+				return Positive; // Source done
+			if (!res)
+				break;
+
+			mHeld = true;
+		}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mMtxWorkers);
+#endif
+		pWorker = workerSelect(mPeerHeld.particle);
+		if (!pWorker)
+		{
+			// Peer is held back. Not dispatching any
+			// further lets the source queue fill up
+			if (!mSaturated)
+				++mBackpressure;
+			mSaturated = true;
+
+			break;
+		}
+
+		mSaturated = false;
+
+		res = pWorker->ppPeer.commit(mPeerHeld.particle, mPeerHeld.t1, nowMs());
+		if (res <= 0)
+			break; // Worker stopped in between. Retry
+
+		++pWorker->numConn;
+		++pWorker->numDispatched;
+		++mConnDispatched;
+
+		mHeld = false;
+	}
+
+	return Pending;
+}
+
+/*
+ * Must be called with the worker list locked.
+ * Available workers are ranked by their distance
+ * to the start index. Least connections ranks by
+ * the connection count first
+ */
+TcpDispatchWorker *TcpDispatching::workerSelect(const TcpPeer &peer)
+{
+	size_t numWorkers = mWorkers.size();
+	list<TcpDispatchWorker>::iterator iter;
+	TcpDispatchWorker *pWorker;
+	TcpDispatchWorker *pBest = NULL;
+	size_t idxStart, idx, idxBest = 0;
+	size_t dist, distBest = 0;
+	bool better;
+
+	if (!numWorkers)
+		return NULL;
+
+	if (mStrategy == DispatchPeerHash)
+		idxStart = peerHash(peer) % numWorkers;
+	else
+		idxStart = mIdxNext % numWorkers;
+
+	iter = mWorkers.begin();
+	for (idx = 0; iter != mWorkers.end(); ++iter, ++idx)
+	{
+		pWorker = &(*iter);
+
+		if (!workerAvailable(*pWorker))
+			continue;
+
+		dist = (idx + numWorkers - idxStart) % numWorkers;
+
+		if (!pBest)
+			better = true;
+		else if (mStrategy == DispatchLeastConn && pWorker->numConn != pBest->numConn)
+			better = pWorker->numConn < pBest->numConn;
+		else
+			better = dist < distBest;
+
+		if (!better)
+			continue;
+
+		pBest = pWorker;
+		idxBest = idx;
+		distBest = dist;
+	}
+
+	if (!pBest)
+		return NULL;
+
+	if (mStrategy == DispatchPeerHash)
+	{
+		if (distBest)
+			++mHashSpilled;
+	}
+	else
+		mIdxNext = idxBest + 1;
+
+	return pBest;
+}
+
+bool TcpDispatching::workerAvailable(TcpDispatchWorker &worker)
+{
+	if (worker.ppPeer.sinkDone())
+		return false;
+
+	if (worker.numConnMax && worker.numConn >= worker.numConnMax)
+		return false;
+
+	return !worker.ppPeer.isFull();
+}
+
+Success TcpDispatching::shutdown()
+{
+	PipeEntry<TcpPeer> peer;
+
+	if (mHeld)
+		TcpListening::peerClose(mPeerHeld.particle);
+	mHeld = false;
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mMtxWorkers);
+#endif
+	list<TcpDispatchWorker>::iterator iter;
+
+	iter = mWorkers.begin();
+	for (; iter != mWorkers.end(); ++iter)
+	{
+		iter->ppPeer.sourceDoneSet();
+
+		while (iter->ppPeer.get(peer) > 0)
+			TcpListening::peerClose(peer.particle);
+	}
+
+	return Positive;
+}
+
+void TcpDispatching::processInfo(char *pBuf, char *pBufEnd)
+{
+	//dInfo("State\t\t\t%s\n", ProcStateString[mState]);
+
+	dInfo("Strategy\t\t%s\n", DispatchStrategyString[mStrategy]);
+	dInfo("Dispatched\t\t%u\n", mConnDispatched);
+	if (mBackpressure)
+		dInfo("Backpressure\t\t%u%s\n", mBackpressure, mSaturated ? ". Saturated" : "");
+	if (mHashSpilled)
+		dInfo("Hash spilled\t\t%u\n", mHashSpilled);
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mMtxWorkers);
+#endif
+	list<TcpDispatchWorker>::iterator iter;
+	size_t idx = 0;
+
+	iter = mWorkers.begin();
+	for (; iter != mWorkers.end(); ++iter, ++idx)
+	{
+		dInfo("Worker %zu\t\t%zu", idx, iter->numConn);
+		if (iter->numConnMax)
+			dInfo("/%zu", iter->numConnMax);
+		dInfo(". Dispatched %u\n", iter->numDispatched);
+	}
+}
+
+/* static functions */
+
+// Same hash as the source table of TcpListening. The port is ignored
+uint32_t TcpDispatching::peerHash(const TcpPeer &peer)
+{
+	uint8_t key[16];
+
+	if (!TcpSourceTable::keyGet(peer.addr, key))
+		return 0;
+
+	return TcpSourceTable::keyHash(key);
+}
+
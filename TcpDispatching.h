@@ -0,0 +1,140 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef TCP_DISPATCHING_H
+#define TCP_DISPATCHING_H
+
+#include <list>
+
+#include "Processing.h"
+#include "Pipe.h"
+#include "TcpTransfering.h"
+
+enum DispatchStrategy
+{
+	DispatchRoundRobin = 0,
+	DispatchLeastConn,
+	DispatchPeerHash,
+};
+
+/*
+ * Handed to a worker process by workerAdd(). The worker
+ * drains ppPeer and reports finished connections with
+ * TcpDispatching::connRelease()
+ */
+struct TcpDispatchWorker
+{
+	TcpDispatchWorker()
+		: ppPeer()
+		, numConn(0)
+		, numConnMax(0)
+		, numDispatched(0)
+	{}
+
+	Pipe<TcpPeer> ppPeer;
+	size_t numConn; // Queued and active
+	size_t numConnMax; // 0: Unlimited
+	uint32_t numDispatched;
+};
+
+/*
+ * Distributes accepted connections to worker processes.
+ * Every worker usually runs on its own driver. A peer is
+ * held back while all workers are saturated. The source
+ * queue then fills up and the listener sheds load.
+ * The dispatcher must outlive its workers
+ */
+class TcpDispatching : public Processing
+{
+
+public:
+
+	static TcpDispatching *create()
+	{
+		return new (std::nothrow) TcpDispatching;
+	}
+
+	void sourceSet(Pipe<TcpPeer> *pPeers);
+	void strategySet(DispatchStrategy strategy);
+	TcpDispatchWorker *workerAdd(size_t numConnMax = 0);
+	void connRelease(TcpDispatchWorker *pWorker);
+
+protected:
+
+	virtual ~TcpDispatching() {}
+
+private:
+
+	TcpDispatching();
+	TcpDispatching(const TcpDispatching &) = delete;
+	TcpDispatching &operator=(const TcpDispatching &) = delete;
+
+	/*
+	 * Naming of functions:  objectVerb()
+	 * Example:              peerAdd()
+	 */
+
+	/* member functions */
+	Success process();
+	Success shutdown();
+
+	Success peersDispatch();
+	TcpDispatchWorker *workerSelect(const TcpPeer &peer);
+	bool workerAvailable(TcpDispatchWorker &worker);
+	void processInfo(char *pBuf, char *pBufEnd);
+
+	/* member variables */
+	Pipe<TcpPeer> *mpPeers;
+	DispatchStrategy mStrategy;
+#if CONFIG_PROC_HAVE_DRIVERS
+	std::mutex mMtxWorkers;
+#endif
+	std::list<TcpDispatchWorker> mWorkers;
+	size_t mIdxNext;
+	PipeEntry<TcpPeer> mPeerHeld;
+	bool mHeld;
+	bool mSaturated;
+
+	// statistics
+	uint32_t mConnDispatched;
+	uint32_t mBackpressure;
+	uint32_t mHashSpilled;
+
+	/* static functions */
+	static uint32_t peerHash(const TcpPeer &peer);
+
+	/* static variables */
+
+	/* constants */
+
+};
+
+#endif
+
@@ -32,6 +32,10 @@
 #ifndef _WIN32
 #include <unistd.h>
 #endif
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <netinet/tcp.h>
+#endif
 #include "TcpListening.h"
 
 /* Following include because of
@@ -55,7 +59,13 @@ dProcessStateStr(ProcState);
 
 using namespace std;
 
-#define dCntSkipMax 30
+// Connections accepted per socket and wake
+#ifndef CONFIG_PROC_TCP_ACCEPT_BUDGET
+#define CONFIG_PROC_TCP_ACCEPT_BUDGET	32
+#endif
+
+// Without socket events only
+#define dIntervalPollMs 5
 
 TcpListening::TcpListening()
 	: Processing("TcpListening")
@@ -63,12 +73,31 @@ TcpListening::TcpListening()
 	, mLocalOnly(false)
 	, mMaxConn(200)
 	, mInterrupted(false)
-	, mCntSkip(0)
+	, mAcceptBudget(CONFIG_PROC_TCP_ACCEPT_BUDGET)
+	, mReusePort(false)
+	, mNumShardsCpu(0)
+	, mPollMs(0)
+	, mBacklog(CONFIG_PROC_TCP_LISTEN_BACKLOG)
+	, mDeferAcceptSec(0)
+	, mLenQueueFastOpen(0)
+	, mRatePerSec(0)
+	, mRateBurst(0)
+	, mTokensMilli(0)
+	, mRefillMs(0)
+	, mThrottled(false)
+	, mSrcConnMax(0)
+	, mSrcNumMax(0)
+	, mpSources(NULL)
 	, mFdLstIPv4(INVALID_SOCKET)
 	, mFdLstIPv6(INVALID_SOCKET)
+	, mEvtsIPv4()
+	, mEvtsIPv6()
 	, mAddrIPv4("")
 	, mAddrIPv6("")
 	, mConnCreated(0)
+	, mBudgetExhausted(0)
+	, mRateLimited(0)
+	, mSrcRejected(0)
 {
 	mState = StStart;
 }
@@ -84,6 +113,128 @@ void TcpListening::maxConnSet(size_t maxConn)
 	mMaxConn = maxConn;
 }
 
+/*
+ * Limits the connections accepted in one tick. The rest
+ * is accepted in the next ticks. Other processes of the
+ * driver keep running during connection storms.
+ * 0: Unlimited
+ */
+void TcpListening::acceptBudgetSet(size_t numConn)
+{
+	mAcceptBudget = numConn;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/socket.7.html
+ *   SO_REUSEPORT
+ * - https://lwn.net/Articles/542629/
+ *
+ * Sharding: Every shard is a separate listener with this option,
+ * started by a process on its own driver. The kernel distributes
+ * the connections. The shards don't share a queue.
+ * Must be called before the listener is started
+ */
+void TcpListening::reusePortSet(bool enable)
+{
+	mReusePort = enable;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/socket.7.html
+ *   SO_ATTACH_REUSEPORT_CBPF
+ *
+ * Connections received by CPU n are given to the shard with
+ * the index n % numShards. The index is the order in which
+ * the shards started listening. Linux only. Requires reusePortSet()
+ */
+void TcpListening::cpuSteeringSet(size_t numShards)
+{
+	mNumShardsCpu = numShards;
+}
+
+/*
+ * Must be called before the listener is started.
+ * Buffer sizes are set on the listening socket already
+ * because the window scaling is negotiated during the handshake
+ */
+void TcpListening::tuningSet(const TcpTuning &tuning)
+{
+	mTuning = tuning;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/listen.2.html
+ *
+ * Limited by the system. Linux: net.core.somaxconn
+ */
+void TcpListening::backlogSet(int numConn)
+{
+	mBacklog = numConn;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/tcp.7.html
+ *   TCP_DEFER_ACCEPT
+ *
+ * For protocols where the client sends first. Connections
+ * are accepted when data has arrived. Half-open connections
+ * and silent clients don't wake the listener. Linux only.
+ * 0: Disabled
+ */
+void TcpListening::deferAcceptSet(int timeoutSec)
+{
+	mDeferAcceptSec = timeoutSec;
+}
+
+/*
+ * Literature
+ * - https://www.rfc-editor.org/rfc/rfc7413
+ * - https://docs.kernel.org/networking/ip-sysctl.html
+ *   tcp_fastopen
+ *
+ * Server side of TCP Fast Open. Data of the SYN is readable
+ * right after accept(). Queue length: Pending TFO requests.
+ * Linux: Needs net.ipv4.tcp_fastopen & 2. 0: Disabled
+ */
+void TcpListening::fastOpenSet(int lenQueue)
+{
+	mLenQueueFastOpen = lenQueue;
+}
+
+/*
+ * Literature
+ * - https://en.wikipedia.org/wiki/Token_bucket
+ *
+ * Connections not admitted yet stay in the backlog of
+ * the kernel. The socket events are paused meanwhile.
+ * 0: Unlimited. Burst 0: One second of connections
+ */
+void TcpListening::acceptRateSet(uint32_t connPerSec, uint32_t burst)
+{
+	mRatePerSec = connPerSec;
+	mRateBurst = burst ? burst : connPerSec;
+}
+
+/*
+ * Concurrent connections per source IP address. Further
+ * connections are closed right after accept(). Also when
+ * numSourcesMax different addresses are connected already.
+ * numConnMax = 0: No limit. numSourcesMax = 0: Default
+ * Must be called before the listener is started
+ */
+void TcpListening::sourceLimitSet(size_t numConnMax, size_t numSourcesMax)
+{
+	if (!numSourcesMax)
+		numSourcesMax = CONFIG_PROC_TCP_SOURCES_MAX;
+
+	mSrcConnMax = numConnMax;
+	mSrcNumMax = numSourcesMax;
+}
+
 /*
 Literature socket programming:
 - http://man7.org/linux/man-pages/man2/poll.2.html
@@ -91,6 +242,8 @@ Literature socket programming:
 */
 Success TcpListening::process()
 {
+	uint32_t curTimeMs;
+	bool pollDue;
 	Success success;
 #ifdef _WIN32
 	bool ok;
@@ -109,6 +262,16 @@ Success TcpListening::process()
 		if (!ok)
 			return procErrLog(-1, "could not init WSA");
 #endif
+		if (mSrcConnMax)
+		{
+			mpSources = TcpSourceTable::create(mSrcNumMax, mSrcConnMax);
+			if (!mpSources)
+				return procErrLog(-1, "could not create source table");
+		}
+
+		mTokensMilli = (uint64_t)mRateBurst * 1000;
+		mRefillMs = nowMs();
+
 		//procDbgLog("creating listening sockets");
 
 		success = socketCreate(false, mFdLstIPv4, mAddrIPv4);
@@ -124,35 +287,55 @@ Success TcpListening::process()
 
 		//procDbgLog("creating listening sockets: done");
 
+		// Each socket falls back to polling on its own
+		sockEvtsRegister(mEvtsIPv4, mFdLstIPv4);
+
+		if (mFdLstIPv6 != INVALID_SOCKET)
+			sockEvtsRegister(mEvtsIPv6, mFdLstIPv6);
+
 		mState = StMain;
 
 		break;
 	case StMain:
 
-		++mCntSkip;
-		if (mCntSkip < dCntSkipMax)
-			return Pending;
-		mCntSkip = 0;
-
-		while (1)
+		if (mThrottled)
 		{
-			success = connectionsAccept(mFdLstIPv4);
-			if (success != Positive)
-				break;
+			if (!tokensRefill())
+				return Pending;
+
+			mThrottled = false;
+
+			sockEvtsInterestSet(mEvtsIPv4, SockEvtRead);
+			sockEvtsInterestSet(mEvtsIPv6, SockEvtRead);
 		}
 
-		if (success != Pending)
-			return success;
+		// Without socket events we poll the sockets.
+		// Time based. Independent of the tick rate
+		pollDue = false;
+		if (!sockEvtsRegistered(mEvtsIPv4) ||
+				(mFdLstIPv6 != INVALID_SOCKET && !sockEvtsRegistered(mEvtsIPv6)))
+		{
+			curTimeMs = nowMs();
+			if (curTimeMs - mPollMs >= dIntervalPollMs)
+			{
+				mPollMs = curTimeMs;
+				pollDue = true;
+			}
+		}
 
-		while (1)
+		if (pollDue || sockEvtsRegistered(mEvtsIPv4))
 		{
-			success = connectionsAccept(mFdLstIPv6);
-			if (success != Positive)
-				break;
+			success = connectionsAcceptAll(mFdLstIPv4, mEvtsIPv4);
+			if (success != Pending)
+				return success;
 		}
 
-		if (success != Pending)
-			return success;
+		if (pollDue || sockEvtsRegistered(mEvtsIPv6))
+		{
+			success = connectionsAcceptAll(mFdLstIPv6, mEvtsIPv6);
+			if (success != Pending)
+				return success;
+		}
 
 		if (mInterrupted)
 			return Positive;
@@ -216,6 +399,7 @@ Success TcpListening::socketCreate(bool isIPv6, SOCKET &fdLst, string &strAddr)
 
 	// create and configure socket
 
+	const char *pOpt;
 	int opt;
 
 	// IMPORTANT
@@ -237,6 +421,21 @@ Success TcpListening::socketCreate(bool isIPv6, SOCKET &fdLst, string &strAddr)
 	if (::setsockopt(fdLst, SOL_SOCKET, SO_REUSEADDR, (const char *)&opt, sizeof(opt)))
 		return procErrLog(-1, "setsockopt(SO_REUSEADDR) failed: %s", errnoToStr(errGet()).c_str());
 
+	if (mReusePort)
+	{
+#ifdef SO_REUSEPORT
+		opt = 1;
+		if (::setsockopt(fdLst, SOL_SOCKET, SO_REUSEPORT, (const char *)&opt, sizeof(opt)))
+			return procErrLog(-1, "setsockopt(SO_REUSEPORT) failed: %s", errnoToStr(errGet()).c_str());
+#else
+		return procErrLog(-1, "SO_REUSEPORT not supported");
+#endif
+	}
+
+	pOpt = TcpTransfering::tuningApply(fdLst, mTuning);
+	if (pOpt)
+		return procErrLog(-1, "setsockopt(%s) failed: %s", pOpt, errnoToStr(errGet()).c_str());
+
 	ok = fileNonBlockingSet(fdLst);
 	if (!ok)
 		return procErrLog(-1, "could not set non blocking mode: %s",
@@ -261,28 +460,137 @@ Success TcpListening::socketCreate(bool isIPv6, SOCKET &fdLst, string &strAddr)
 		return -1;
 	}
 
-	if (::listen(fdLst, 8192) < 0)
+#if defined(__linux__)
+	// Not fatal. Connections work without
+	if (mDeferAcceptSec &&
+		::setsockopt(fdLst, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+			(const char *)&mDeferAcceptSec, sizeof(mDeferAcceptSec)))
+		procWrnLog("setsockopt(TCP_DEFER_ACCEPT) failed: %s", errnoToStr(errGet()).c_str());
+
+	if (mLenQueueFastOpen &&
+		::setsockopt(fdLst, IPPROTO_TCP, TCP_FASTOPEN,
+			(const char *)&mLenQueueFastOpen, sizeof(mLenQueueFastOpen)))
+		procWrnLog("setsockopt(TCP_FASTOPEN) failed: %s", errnoToStr(errGet()).c_str());
+#else
+	if (mDeferAcceptSec || mLenQueueFastOpen)
+		procWrnLog("defer accept and fast open not supported");
+#endif
+	if (::listen(fdLst, mBacklog) < 0)
 		return procErrLog(-1, "listen() failed: %s", errnoToStr(errGet()).c_str());
 
+	if (mReusePort && mNumShardsCpu)
+		cpuSteeringAttach(fdLst);
+
 	return Positive;
 }
 
+/*
+ * Literature
+ * - https://www.kernel.org/doc/html/latest/networking/filter.html
+ * - https://github.com/torvalds/linux/blob/master/tools/testing/selftests/net/reuseport_bpf_cpu.c
+ *
+ * The program applies to the whole group of the port.
+ * Indices outside of the group fall back to hashing
+ */
+void TcpListening::cpuSteeringAttach(SOCKET fdLst)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+	struct sock_filter code[] =
+	{
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU) },
+		{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)mNumShardsCpu },
+		{ BPF_RET | BPF_A, 0, 0, 0 },
+	};
+	struct sock_fprog prog;
+
+	prog.len = sizeof(code) / sizeof(code[0]);
+	prog.filter = code;
+
+	if (::setsockopt(fdLst, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)))
+		procWrnLog("could not attach steering program: %s", errnoToStr(errGet()).c_str());
+#else
+	(void)fdLst;
+	procWrnLog("CPU steering not supported");
+#endif
+}
+
+Success TcpListening::connectionsAcceptAll(SOCKET &fdLst, SocketEvents &evts)
+{
+	size_t numAccepted = 0;
+	Success success;
+
+	if (sockEvtsRegistered(evts) && !(sockEvtsGet(evts) & SockEvtRead))
+		return Pending;
+
+	while (1)
+	{
+		// Event stays pending. Continued in the next tick
+		if (mAcceptBudget && numAccepted >= mAcceptBudget)
+		{
+			++mBudgetExhausted;
+
+			// Polling: Also continue in the next tick
+			mPollMs = nowMs() - dIntervalPollMs;
+
+			return Pending;
+		}
+
+		// Event stays pending. Driver is not woken up
+		// by the backlog until tokens are refilled
+		if (mRatePerSec && !tokensRefill())
+		{
+			mThrottled = true;
+			++mRateLimited;
+
+			sockEvtsInterestSet(mEvtsIPv4, 0);
+			sockEvtsInterestSet(mEvtsIPv6, 0);
+
+			return Pending;
+		}
+
+		success = connectionsAccept(fdLst);
+		if (success != Positive)
+			break;
+
+		if (mRatePerSec)
+			mTokensMilli -= 1000;
+
+		++numAccepted;
+	}
+
+	if (success == Pending)
+		sockEvtsClear(evts, SockEvtRead);
+
+	return success;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/accept.2.html
+ *   accept4()
+ *
+ * The peer address is taken from accept(). Strings
+ * are created by TcpTransfering on demand
+ */
 Success TcpListening::connectionsAccept(SOCKET &fdLst)
 {
 	if (fdLst == INVALID_SOCKET)
 		return Pending;
 
-	SOCKET peerSocketFd;
-	struct sockaddr_storage addr;
+	TcpPeer peer;
 	socklen_t addrLen;
-	string strAddr;
-	uint16_t numPort;
-	bool isIPv6, ok;
+	const char *pOpt;
 	int numErr;
-	int res;
 
-	peerSocketFd = ::accept(fdLst, NULL, NULL);
-	if (peerSocketFd == INVALID_SOCKET)
+	addrLen = sizeof(peer.addr);
+#if defined(__linux__) || defined(__FreeBSD__)
+	peer.fd = ::accept4(fdLst, (struct sockaddr *)&peer.addr, &addrLen,
+						SOCK_NONBLOCK | SOCK_CLOEXEC);
+	peer.nonBlocking = true;
+#else
+	peer.fd = ::accept(fdLst, (struct sockaddr *)&peer.addr, &addrLen);
+#endif
+	if (peer.fd == INVALID_SOCKET)
 	{
 		numErr = errGet();
 #ifdef _WIN32
@@ -299,37 +607,33 @@ Success TcpListening::connectionsAccept(SOCKET &fdLst)
 		return Pending;
 	}
 
-	memset(&addr, 0, sizeof(addr));
-	addrLen = sizeof(addr);
-
-	res = ::getpeername(peerSocketFd, (struct sockaddr *)&addr, &addrLen);
-	if (!res)
+	// Rejected before any option is set or process is created
+	if (mpSources && !mpSources->connAdd(peer.addr))
 	{
-		ok = TcpTransfering::sockaddrInfoGet(addr, strAddr, numPort, isIPv6);
-		if (!ok)
-			return procErrLog(-1, "could not get socket address info");
-
-		procDbgLog("got peer %s%s%s:%u",
-				isIPv6 ? "[" : "",
-				strAddr.c_str(),
-				isIPv6 ? "]" : "",
-				numPort);
+		socketClose(peer.fd);
+		++mSrcRejected;
+		return Positive;
 	}
 
+	peer.pSources = mpSources;
+
+	// Not all systems inherit the options of the listening socket
+	pOpt = TcpTransfering::tuningApply(peer.fd, mTuning);
+	if (pOpt)
+		procWrnLog("setsockopt(%s) failed: %s", pOpt, errnoToStr(errGet()).c_str());
+
+	peer.portLocal = mPort;
+
 	if (ppPeerFd.isFull() || ppPeerFd.size() >= mMaxConn)
 	{
 		procWrnLog("dropping connection. Output queue full");
-#ifdef _WIN32
-		::closesocket(peerSocketFd);
-#else
-		::close(peerSocketFd);
-#endif
+		peerClose(peer);
 		// give internal side of system time
 		// to consume queue -> Pending
 		return Pending;
 	}
 
-	ppPeerFd.commit(peerSocketFd, nowMs());
+	ppPeerFd.commit(peer, nowMs());
 	++mConnCreated;
 
 	return Positive;
@@ -337,17 +641,81 @@ Success TcpListening::connectionsAccept(SOCKET &fdLst)
 
 Success TcpListening::shutdown()
 {
-	PipeEntry<SOCKET> peerFd;
+	PipeEntry<TcpPeer> peerFd;
 
 	while (ppPeerFd.get(peerFd) > 0)
-		socketClose(peerFd.particle);
+		peerClose(peerFd.particle);
+
+	sockEvtsUnregister(mEvtsIPv4);
+	sockEvtsUnregister(mEvtsIPv6);
 
 	socketClose(mFdLstIPv4);
 	socketClose(mFdLstIPv6);
 
+	// Connections still using the table keep it alive
+	if (mpSources)
+		mpSources->release();
+	mpSources = NULL;
+
 	return Positive;
 }
 
+// Also releases the slot in the source table
+/*
+ * For applications working with plain file descriptors.
+ * The peer address is dropped. A source counted by sourceLimitSet()
+ * is released immediately, so only queued connections are limited
+ * Return: INVALID_SOCKET if no connection is pending
+ */
+SOCKET TcpListening::nextPeerFd()
+{
+	PipeEntry<TcpPeer> peer;
+	SOCKET fd;
+
+	if (ppPeerFd.get(peer) < 1)
+		return INVALID_SOCKET;
+
+	fd = peer.particle.fd;
+
+	// Source only
+	peer.particle.fd = INVALID_SOCKET;
+	peerClose(peer.particle);
+
+	return fd;
+}
+
+void TcpListening::peerClose(TcpPeer &peer)
+{
+	if (peer.fd != INVALID_SOCKET)
+	{
+#ifdef _WIN32
+		::closesocket(peer.fd);
+#else
+		::close(peer.fd);
+#endif
+	}
+	peer.fd = INVALID_SOCKET;
+
+	if (peer.pSources)
+		peer.pSources->connRemove(peer.addr);
+	peer.pSources = NULL;
+}
+
+// Return: At least one token available
+bool TcpListening::tokensRefill()
+{
+	uint32_t curTimeMs = nowMs();
+	uint64_t tokensMax = (uint64_t)mRateBurst * 1000;
+
+	mTokensMilli += (uint64_t)(curTimeMs - mRefillMs) * mRatePerSec;
+	if (mTokensMilli > tokensMax)
+		mTokensMilli = tokensMax;
+
+	mRefillMs = curTimeMs;
+
+	return mTokensMilli >= 1000;
+}
+
 void TcpListening::socketClose(SOCKET &fd)
 {
 	if (fd == INVALID_SOCKET)
@@ -445,7 +813,214 @@ void TcpListening::processInfo(char *pBuf, char *pBufEnd)
 
 	dInfo("\n");
 
+	if (mReusePort)
+		dInfo("Shard%s\n", mNumShardsCpu ? ". CPU steering" : "");
+	if (mDeferAcceptSec)
+		dInfo("Defer accept\t\t%ds\n", mDeferAcceptSec);
+	if (mLenQueueFastOpen)
+		dInfo("Fast open queue\t\t%d\n", mLenQueueFastOpen);
+
 	dInfo("Connections created\t%d\n", (int)mConnCreated);
+	if (mBudgetExhausted)
+		dInfo("Budget exhausted\t%u\n", mBudgetExhausted);
+	if (mRatePerSec)
+		dInfo("Rate limited\t\t%u%s\n", mRateLimited, mThrottled ? ". Throttled" : "");
+	if (mpSources)
+		dInfo("Sources\t\t\t%zu. Rejected %u\n", mpSources->numSources(), mSrcRejected);
 	dInfo("Queue\t\t\t%zu\n", ppPeerFd.size());
 }
 
+
+/* TcpSourceTable */
+
+// Load factor of at most 0.5
+TcpSourceTable::TcpSourceTable(size_t numSourcesMax, size_t numConnMax)
+	: mSlots()
+	, mMask(0)
+	, mNumSourcesMax(numSourcesMax)
+	, mNumConnMax(numConnMax)
+	, mNumSources(0)
+	, mNumRefs(1)
+	, mSeed(0)
+{
+	size_t numSlots = 16;
+
+	while (numSlots < 2 * numSourcesMax)
+		numSlots <<= 1;
+
+	mSlots.resize(numSlots);
+	mMask = numSlots - 1;
+
+	for (size_t i = 0; i < numSlots; ++i)
+		mSlots[i].numConn = 0;
+
+	// Addresses chosen by a client shouldn't collide on purpose
+	mSeed = nowMs() ^ (uint32_t)(uintptr_t)this;
+}
+
+// Return: Connection admitted
+bool TcpSourceTable::connAdd(const struct sockaddr_storage &addr)
+{
+	uint8_t key[16];
+	size_t idx;
+
+	if (!keyGet(addr, key))
+		return true;
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mMtx);
+#endif
+	idx = slotFind(key);
+
+	SourceSlot &slot = mSlots[idx];
+
+	if (slot.numConn)
+	{
+		if (slot.numConn >= mNumConnMax || slot.numConn == UINT16_MAX)
+			return false;
+	}
+	else
+	{
+		if (mNumSources >= mNumSourcesMax)
+			return false;
+
+		memcpy(slot.key, key, sizeof(key));
+		++mNumSources;
+	}
+
+	++slot.numConn;
+	++mNumRefs;
+
+	return true;
+}
+
+void TcpSourceTable::connRemove(const struct sockaddr_storage &addr)
+{
+	uint8_t key[16];
+	size_t idx;
+	bool unused;
+
+	if (!keyGet(addr, key))
+		return;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mMtx);
+#endif
+		idx = slotFind(key);
+
+		SourceSlot &slot = mSlots[idx];
+
+		if (!slot.numConn)
+			return;
+
+		--slot.numConn;
+		if (!slot.numConn)
+		{
+			slotClear(idx);
+			--mNumSources;
+		}
+
+		--mNumRefs;
+		unused = !mNumRefs;
+	}
+
+	if (unused)
+		delete this;
+}
+
+// Called by the owner instead of delete
+void TcpSourceTable::release()
+{
+	bool unused;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mMtx);
+#endif
+		--mNumRefs;
+		unused = !mNumRefs;
+	}
+
+	if (unused)
+		delete this;
+}
+
+size_t TcpSourceTable::numSources()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mMtx);
+#endif
+	return mNumSources;
+}
+
+bool TcpSourceTable::keyGet(const struct sockaddr_storage &addr, uint8_t *pKey)
+{
+	if (addr.ss_family == AF_INET6)
+	{
+		memcpy(pKey, &((const struct sockaddr_in6 *)&addr)->sin6_addr, 16);
+		return true;
+	}
+
+	if (addr.ss_family != AF_INET)
+		return false;
+
+	memset(pKey, 0, 10);
+	pKey[10] = 0xFF;
+	pKey[11] = 0xFF;
+	memcpy(pKey + 12, &((const struct sockaddr_in *)&addr)->sin_addr, 4);
+
+	return true;
+}
+
+// Return: Index of the matching or the first empty slot
+size_t TcpSourceTable::slotFind(const uint8_t *pKey)
+{
+	size_t idx = keyHash(pKey, mSeed) & mMask;
+
+	while (mSlots[idx].numConn && memcmp(mSlots[idx].key, pKey, 16))
+		idx = (idx + 1) & mMask;
+
+	return idx;
+}
+
+// Following entries are shifted back. No tombstones needed
+void TcpSourceTable::slotClear(size_t idx)
+{
+	size_t idxNext = idx;
+	size_t idxHome;
+
+	while (1)
+	{
+		idxNext = (idxNext + 1) & mMask;
+
+		if (!mSlots[idxNext].numConn)
+			break;
+
+		idxHome = keyHash(mSlots[idxNext].key, mSeed) & mMask;
+
+		// Home between the cleared and the next slot: Stays
+		if (((idxNext - idxHome) & mMask) < ((idxNext - idx) & mMask))
+			continue;
+
+		mSlots[idx] = mSlots[idxNext];
+		idx = idxNext;
+	}
+
+	mSlots[idx].numConn = 0;
+}
+
+/*
+ * Literature
+ * - http://www.isthe.com/chongo/tech/comp/fnv/index.html
+ */
+uint32_t TcpSourceTable::keyHash(const uint8_t *pKey, uint32_t seed)
+{
+	uint32_t hash = 2166136261u ^ seed;
+
+	for (size_t i = 0; i < 16; ++i)
+	{
+		hash ^= pKey[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
@@ -33,6 +33,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 
 #ifdef _WIN32
 // https://learn.microsoft.com/en-us/cpp/porting/modifying-winver-and-win32-winnt?view=msvc-170
@@ -57,6 +58,8 @@
 
 #include "Processing.h"
 #include "Pipe.h"
+#include "SocketEvents.h"
+#include "TcpTransfering.h"
 
 /* Literature
  * - https://handsonnetworkprogramming.com/articles/differences-windows-winsock-linux-unix-bsd-sockets-compatibility/
@@ -69,6 +72,71 @@
 #endif
 #endif
 
+#ifndef CONFIG_PROC_TCP_LISTEN_BACKLOG
+#define CONFIG_PROC_TCP_LISTEN_BACKLOG		8192
+#endif
+
+#ifndef CONFIG_PROC_TCP_SOURCES_MAX
+#define CONFIG_PROC_TCP_SOURCES_MAX			4096
+#endif
+
+/*
+ * Concurrent connections per source IP address.
+ * Open addressing with linear probing. IPv4 is stored
+ * as IPv4-mapped IPv6. Shared by the listener and its
+ * connections. The last one of them deletes the table
+ *
+ * Literature
+ * - https://en.wikipedia.org/wiki/Linear_probing#Deletion
+ */
+class TcpSourceTable
+{
+
+public:
+
+	static TcpSourceTable *create(size_t numSourcesMax, size_t numConnMax)
+	{
+		return new (std::nothrow) TcpSourceTable(numSourcesMax, numConnMax);
+	}
+
+	bool connAdd(const struct sockaddr_storage &addr);
+	void connRemove(const struct sockaddr_storage &addr);
+	void release();
+	size_t numSources();
+
+	// IPv4 as mapped IPv6 address. Also used by TcpDispatching
+	static bool keyGet(const struct sockaddr_storage &addr, uint8_t *pKey);
+	static uint32_t keyHash(const uint8_t *pKey, uint32_t seed = 0);
+
+private:
+
+	TcpSourceTable() = delete;
+	TcpSourceTable(size_t numSourcesMax, size_t numConnMax);
+	TcpSourceTable(const TcpSourceTable &) = delete;
+	TcpSourceTable &operator=(const TcpSourceTable &) = delete;
+	~TcpSourceTable() {}
+
+	struct SourceSlot
+	{
+		uint8_t key[16];
+		uint16_t numConn; // 0: Empty
+	};
+
+	size_t slotFind(const uint8_t *pKey);
+	void slotClear(size_t idx);
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	std::mutex mMtx;
+#endif
+	std::vector<SourceSlot> mSlots;
+	size_t mMask;
+	size_t mNumSourcesMax;
+	size_t mNumConnMax;
+	size_t mNumSources;
+	size_t mNumRefs;
+	uint32_t mSeed;
+};
+
 class TcpListening : public Processing
 {
 
@@ -81,9 +149,21 @@ public:
 
 	void portSet(uint16_t port, bool localOnly = false);
 	void maxConnSet(size_t maxConn);
+	void acceptBudgetSet(size_t numConn);
+	void reusePortSet(bool enable);
+	void cpuSteeringSet(size_t numShards);
+	void tuningSet(const TcpTuning &tuning);
+	void backlogSet(int numConn);
+	void deferAcceptSet(int timeoutSec);
+	void fastOpenSet(int lenQueue);
+	void acceptRateSet(uint32_t connPerSec, uint32_t burst = 0);
+	void sourceLimitSet(size_t numConnMax,
+						size_t numSourcesMax = CONFIG_PROC_TCP_SOURCES_MAX);
 
 	SOCKET nextPeerFd();
-	Pipe<SOCKET> ppPeerFd;
+	Pipe<TcpPeer> ppPeerFd;
+
+	static void peerClose(TcpPeer &peer);
 
 protected:
 
@@ -99,7 +179,10 @@ private:
 	Success shutdown();
 
 	Success socketCreate(bool isIPv6, SOCKET &fdLst, std::string &strAddr);
+	Success connectionsAcceptAll(SOCKET &fdLst, SocketEvents &evts);
 	Success connectionsAccept(SOCKET &fdLst);
+	void cpuSteeringAttach(SOCKET fdLst);
+	bool tokensRefill();
 	void socketClose(SOCKET &fd);
 
 	int errGet();
@@ -111,16 +194,38 @@ private:
 	bool mLocalOnly;
 	size_t mMaxConn;
 	bool mInterrupted;
-	uint32_t mCntSkip;
+	size_t mAcceptBudget;
+	bool mReusePort;
+	size_t mNumShardsCpu;
+	uint32_t mPollMs;
+	TcpTuning mTuning;
+	int mBacklog;
+	int mDeferAcceptSec;
+	int mLenQueueFastOpen;
+
+	// admission control
+	uint32_t mRatePerSec;
+	uint32_t mRateBurst;
+	uint64_t mTokensMilli;
+	uint32_t mRefillMs;
+	bool mThrottled;
+	size_t mSrcConnMax;
+	size_t mSrcNumMax;
+	TcpSourceTable *mpSources;
 
 	SOCKET mFdLstIPv4;
 	SOCKET mFdLstIPv6;
+	SocketEvents mEvtsIPv4;
+	SocketEvents mEvtsIPv6;
 	std::string mAddress;
 	std::string mAddrIPv4;
 	std::string mAddrIPv6;
 
 	// statistics
 	uint32_t mConnCreated;
+	uint32_t mBudgetExhausted;
+	uint32_t mRateLimited;
+	uint32_t mSrcRejected;
 };
 
 #endif
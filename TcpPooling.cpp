@@ -0,0 +1,322 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <chrono>
+
+#include "TcpPooling.h"
+
+#define dForEach_ProcState(gen) \
+		gen(StStart) \
+		gen(StMain) \
+
+#define dGenProcStateEnum(s) s,
+dProcessStateEnum(ProcState);
+
+#if 0
+#define dGenProcStateString(s) #s,
+dProcessStateStr(ProcState);
+#endif
+
+#define dForEach_PoolConnState(gen) \
+		gen(Connecting) \
+		gen(Idle) \
+		gen(Failed) \
+
+#define dGenPoolConnStateString(s) #s,
+static const char *PoolConnStateString[] = {
+	dForEach_PoolConnState(dGenPoolConnStateString)
+};
+
+using namespace std;
+using namespace chrono;
+
+TcpPooling::TcpPooling()
+	: Processing("TcpPooling")
+	, mConns()
+	, mNumIdleMax(CONFIG_PROC_TCP_POOL_IDLE_MAX)
+	, mIdleTmoMs(CONFIG_PROC_TCP_POOL_IDLE_TMO_MS)
+	, mConnCreated(0)
+	, mConnLeased(0)
+{
+	mState = StStart;
+}
+
+/*
+ * Return value
+ *   Positive connection handed over to the user
+ *   Pending  connection not ready yet. Try again
+ *   < 0      could not connect to host
+ */
+Success TcpPooling::connLease(Processing *pUser,
+					const string &hostAddr,
+					uint16_t hostPort,
+					TcpTransfering *&pConn)
+{
+	list<struct TcpPoolingConn>::iterator iter;
+	bool connecting = false;
+	Processing *pProc;
+
+	pConn = NULL;
+
+	if (!pUser)
+		return procErrLog(-1, "user not set");
+
+	string addr = hostAddr;
+
+	if (addr == "localhost")
+		addr = "127.0.0.1";
+
+	// Most recently returned connection first
+	iter = mConns.end();
+	while (iter != mConns.begin())
+	{
+		--iter;
+
+		if (iter->hostPort != hostPort || iter->hostAddr != addr)
+			continue;
+
+		if (iter->state == PoolConnFailed)
+		{
+			mConns.erase(iter);
+			return procErrLog(-2, "could not connect to %s:%u",
+								addr.c_str(), hostPort);
+		}
+
+		if (iter->pTrans->success() != Pending)
+			continue;
+
+		if (!iter->pTrans->mSendReady)
+		{
+			connecting = true;
+			continue;
+		}
+
+		pProc = childHandOver(iter->pTrans, pUser);
+		if (!pProc)
+			return procErrLog(-1, "could not hand over connection");
+
+		++mConnLeased;
+
+		pConn = iter->pTrans;
+		mConns.erase(iter);
+
+		return Positive;
+	}
+
+	if (!connecting)
+		connStart(addr, hostPort);
+
+	return Pending;
+}
+
+// Broken, busy or surplus connections are closed
+void TcpPooling::connReturn(Processing *pUser, TcpTransfering *pConn)
+{
+	if (!pUser || !pConn)
+		return;
+
+	// Key of connLease(). The remote address differs
+	// for host names and non-canonical IPv6 addresses
+	string addr = pConn->hostAddr();
+	uint16_t port = pConn->hostPort();
+
+	bool reusable = addr.size() &&
+					pConn->success() == Pending &&
+					pConn->mSendReady &&
+					!pConn->sendPending() &&
+					!pConn->recvPending() &&
+					pConn->read(NULL, 0) == 0;
+
+	if (!pUser->childHandOver(pConn, this))
+		return;
+
+	if (!reusable || idleCount(addr, port) >= mNumIdleMax)
+	{
+		repel(pConn);
+		return;
+	}
+
+	mConns.push_back({ pConn, addr, port, PoolConnIdle, millis() });
+}
+
+void TcpPooling::idleMaxSet(size_t numIdleMax)
+{
+	mNumIdleMax = numIdleMax;
+}
+
+void TcpPooling::idleTmoSet(uint32_t tmoMs)
+{
+	mIdleTmoMs = tmoMs;
+}
+
+Success TcpPooling::process()
+{
+	uint32_t curTimeMs = millis();
+	list<struct TcpPoolingConn>::iterator iter;
+	TcpTransfering *pTrans;
+	bool closed;
+#if 0
+	dStateTrace;
+#endif
+	switch (mState)
+	{
+	case StStart:
+
+		mState = StMain;
+
+		break;
+	case StMain:
+
+		// Health check of pooled connections
+		iter = mConns.begin();
+		while (iter != mConns.end())
+		{
+			pTrans = iter->pTrans;
+
+			if (iter->state == PoolConnFailed)
+			{
+				if (curTimeMs - iter->startMs > mIdleTmoMs)
+					iter = mConns.erase(iter);
+				else
+					++iter;
+
+				continue;
+			}
+
+			closed = pTrans->success() != Pending;
+
+			if (iter->state == PoolConnConnecting)
+			{
+				if (closed)
+				{
+					repel(pTrans);
+
+					iter->pTrans = NULL;
+					iter->state = PoolConnFailed;
+					iter->startMs = curTimeMs;
+				}
+				else
+				if (pTrans->mSendReady)
+				{
+					iter->state = PoolConnIdle;
+					iter->startMs = curTimeMs;
+				}
+
+				++iter;
+				continue;
+			}
+
+			// Idle connections must not receive data
+			if (!closed && curTimeMs - iter->startMs <= mIdleTmoMs &&
+					pTrans->read(NULL, 0) == 0)
+			{
+				++iter;
+				continue;
+			}
+
+			repel(pTrans);
+			iter = mConns.erase(iter);
+		}
+
+		break;
+	default:
+		break;
+	}
+
+	return Pending;
+}
+
+Success TcpPooling::shutdown()
+{
+	// Children are marked as unused by the abstract process
+	mConns.clear();
+
+	return Positive;
+}
+
+void TcpPooling::connStart(const string &hostAddr, uint16_t hostPort)
+{
+	TcpTransfering *pTrans;
+
+	pTrans = TcpTransfering::create(hostAddr, hostPort);
+	if (!pTrans)
+	{
+		procWrnLog("could not create process");
+		return;
+	}
+
+	start(pTrans);
+
+	mConns.push_back({ pTrans, hostAddr, hostPort, PoolConnConnecting, millis() });
+	++mConnCreated;
+}
+
+size_t TcpPooling::idleCount(const string &hostAddr, uint16_t hostPort)
+{
+	list<struct TcpPoolingConn>::iterator iter;
+	size_t numIdle = 0;
+
+	for (iter = mConns.begin(); iter != mConns.end(); ++iter)
+	{
+		if (iter->state != PoolConnIdle)
+			continue;
+
+		if (iter->hostPort != hostPort || iter->hostAddr != hostAddr)
+			continue;
+
+		++numIdle;
+	}
+
+	return numIdle;
+}
+
+void TcpPooling::processInfo(char *pBuf, char *pBufEnd)
+{
+	//dInfo("State\t\t\t%s\n", ProcStateString[mState]);
+
+	list<struct TcpPoolingConn>::iterator iter;
+
+	dInfo("Connections created\t%d\n", (int)mConnCreated);
+	dInfo("Connections leased\t%d\n", (int)mConnLeased);
+
+	for (iter = mConns.begin(); iter != mConns.end(); ++iter)
+		dInfo("  %s:%u\t\t%s\n",
+				iter->hostAddr.c_str(), iter->hostPort,
+				PoolConnStateString[iter->state]);
+}
+
+/* static functions */
+
+uint32_t TcpPooling::millis()
+{
+	auto now = steady_clock::now();
+	auto nowMs = time_point_cast<milliseconds>(now);
+	return (uint32_t)nowMs.time_since_epoch().count();
+}
@@ -0,0 +1,130 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef TCP_POOLING_H
+#define TCP_POOLING_H
+
+#include <string>
+#include <list>
+
+#include "Processing.h"
+#include "TcpTransfering.h"
+
+// Per host and port
+#ifndef CONFIG_PROC_TCP_POOL_IDLE_MAX
+#define CONFIG_PROC_TCP_POOL_IDLE_MAX			4
+#endif
+
+#ifndef CONFIG_PROC_TCP_POOL_IDLE_TMO_MS
+#define CONFIG_PROC_TCP_POOL_IDLE_TMO_MS		30000
+#endif
+
+enum PoolConnState {
+	PoolConnConnecting = 0,
+	PoolConnIdle,
+	PoolConnFailed,
+};
+
+struct TcpPoolingConn
+{
+	TcpTransfering *pTrans;
+	std::string hostAddr;
+	uint16_t hostPort;
+	enum PoolConnState state;
+	uint32_t startMs;
+};
+
+/*
+ * Leased connections are handed over to the user and show up
+ * in its process tree. They are handed back with connReturn()
+ * or repelled by the user. The pool and its users must be
+ * driven by the same thread
+ */
+class TcpPooling : public Processing
+{
+
+public:
+
+	static TcpPooling *create()
+	{
+		return new (std::nothrow) TcpPooling;
+	}
+
+	Success connLease(Processing *pUser,
+					const std::string &hostAddr,
+					uint16_t hostPort,
+					TcpTransfering *&pConn);
+	void connReturn(Processing *pUser, TcpTransfering *pConn);
+
+	void idleMaxSet(size_t numIdleMax);
+	void idleTmoSet(uint32_t tmoMs);
+
+protected:
+
+	virtual ~TcpPooling() {}
+
+private:
+
+	TcpPooling();
+	TcpPooling(const TcpPooling &) = delete;
+	TcpPooling &operator=(const TcpPooling &) = delete;
+
+	/*
+	 * Naming of functions:  objectVerb()
+	 * Example:              peerAdd()
+	 */
+
+	/* member functions */
+	Success process();
+	Success shutdown();
+
+	void connStart(const std::string &hostAddr, uint16_t hostPort);
+	size_t idleCount(const std::string &hostAddr, uint16_t hostPort);
+	void processInfo(char *pBuf, char *pBufEnd);
+
+	/* member variables */
+	std::list<struct TcpPoolingConn> mConns;
+	size_t mNumIdleMax;
+	uint32_t mIdleTmoMs;
+
+	// statistics
+	uint32_t mConnCreated;
+	uint32_t mConnLeased;
+
+	/* static functions */
+	static uint32_t millis();
+
+	/* static variables */
+
+	/* constants */
+
+};
+
+#endif
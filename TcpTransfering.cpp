@@ -30,19 +30,33 @@
 
 #include <string.h>
 #include <chrono>
+#include <random>
+#include <algorithm>
 #ifndef _WIN32
 #include <unistd.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
+#endif
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/sendfile.h>
 #endif
 
 #include "TcpTransfering.h"
+#include "DnsResolving.h"
+// TcpSourceTable
+#include "TcpListening.h"
 
 #define dForEach_ProcState(gen) \
 		gen(StSrvStart) \
 		gen(StSrvArgCheck) \
 		gen(StCltStart) \
 		gen(StCltArgCheck) \
+		gen(StCltResolveWait) \
+		gen(StCltConnStart) \
 		gen(StCltConnDoneWait) \
+		gen(StCltConnRetryWait) \
 		gen(StCltConnDone) \
 		gen(StConnMain) \
 		gen(StTmp) \
@@ -68,8 +82,29 @@ mutex TcpTransfering::mtxGlobalInit;
 #endif
 bool TcpTransfering::globalInitDone = false;
 #endif
+#if CONFIG_PROC_HAVE_DRIVERS
+mutex TcpTransfering::mtxConnections;
+#endif
+list<TcpTransfering *> TcpTransfering::connections;
 
 #define dTmoDefaultConnDoneMs			2000
+#define dTmoDefaultResolveMs			5000
+// RFC 8305 Section 5
+#define dDelayConnAttemptMs				250
+
+const size_t cNumSendBufsMax = 64;
+const size_t cNumConnAttemptsMax = 8;
+const size_t cSizeStreamChunk = 1024 * 1024;
+#if CONFIG_PROC_HAVE_FILE_SEND && !defined(__linux__)
+const size_t cSizeStreamBuf = 16 * 1024;
+#endif
+
+enum StreamSource
+{
+	StreamStatic = 0,
+	StreamFile,
+	StreamPipe,
+};
 
 /*
  * Literature
@@ -79,41 +114,173 @@ TcpTransfering::TcpTransfering(SOCKET fd)
 	: Transfering("TcpTransfering")
 	, mStartMs(0)
 	, mSocketFd(fd)
+	, mEvts()
+	, mRecv()
+	, mEvtsRead(SockEvtRead)
+	, mSockAddrRemote()
+	, mNonBlocking(false)
+	, mpSources(NULL)
 	, mHostAddrStr("")
 	, mHostPort(0)
-	, mpHostAddr(NULL)
+	, mAddrsConn()
+	, mIdxAddrConn(0)
+	, mConnAttempts()
+	, mAttemptMs(0)
+	, mTmoConnMs(dTmoDefaultConnDoneMs)
+	, mNumRetriesMax(0)
+	, mNumRetries(0)
+	, mBackoffMinMs(0)
+	, mBackoffMaxMs(0)
+	, mDelayRetryMs(0)
+	, mFastOpen(false)
 	, mErrno(0)
 	, mInfoSet(false)
 	, mIsIPv6Local(false)
 	, mIsIPv6Remote(false)
-	, mBytesReceived(0)
-	, mBytesSent(0)
+	, mReadDone(false)
+	, mQuickAckRearm(false)
+	, mBufSend()
+	, mIdxBufSend(0)
+	, mSizeSendMax(CONFIG_PROC_TCP_SIZE_SEND_QUEUE)
+	, mLenSendHigh(CONFIG_PROC_TCP_SIZE_SEND_QUEUE / 2)
+	, mLenSendLow(CONFIG_PROC_TCP_SIZE_SEND_QUEUE / 8)
+	, mSendBlocked(false)
+	, mSrcStream(StreamStatic)
+	, mFdStream(-1)
+	, mOffStream(0)
+	, mpStream(NULL)
+	, mLenStream(0)
+	, mStreamSrcWait(false)
+	, mStats()
+	, mIsServer(true)
 {
 	mState = StSrvStart;
-	addrInfoSet();
 	mSendReady = true;
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxConnections);
+#endif
+	connections.push_back(this);
+}
+
+// Address strings are created on demand. See addrInfoSet()
+TcpTransfering::TcpTransfering(const TcpPeer &peer)
+	: TcpTransfering(peer.fd)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	// Already listed in connections. See statsListStr()
+	Guard lock(mSocketFdMtx);
+#endif
+	mSockAddrRemote = peer.addr;
+	mPortLocal = peer.portLocal;
+	mNonBlocking = peer.nonBlocking;
+	mpSources = peer.pSources;
 }
 
 // strAddrHost can be
 // - IPv4
 // - IPv6
-// - Domain (TODO)
+// - Domain
 TcpTransfering::TcpTransfering(const string &hostAddr, uint16_t hostPort)
 	: Transfering("TcpTransfering")
 	, mStartMs(0)
 	, mSocketFd(INVALID_SOCKET)
+	, mEvts()
+	, mRecv()
+	, mEvtsRead(SockEvtRead)
+	, mSockAddrRemote()
+	, mNonBlocking(false)
+	, mpSources(NULL)
 	, mHostAddrStr(hostAddr)
 	, mHostPort(hostPort)
-	, mpHostAddr(NULL)
+	, mAddrsConn()
+	, mIdxAddrConn(0)
+	, mConnAttempts()
+	, mAttemptMs(0)
+	, mTmoConnMs(dTmoDefaultConnDoneMs)
+	, mNumRetriesMax(0)
+	, mNumRetries(0)
+	, mBackoffMinMs(0)
+	, mBackoffMaxMs(0)
+	, mDelayRetryMs(0)
+	, mFastOpen(false)
 	, mErrno(0)
 	, mInfoSet(false)
 	, mIsIPv6Local(false)
 	, mIsIPv6Remote(false)
-	, mBytesReceived(0)
-	, mBytesSent(0)
+	, mReadDone(false)
+	, mQuickAckRearm(false)
+	, mBufSend()
+	, mIdxBufSend(0)
+	, mSizeSendMax(CONFIG_PROC_TCP_SIZE_SEND_QUEUE)
+	, mLenSendHigh(CONFIG_PROC_TCP_SIZE_SEND_QUEUE / 2)
+	, mLenSendLow(CONFIG_PROC_TCP_SIZE_SEND_QUEUE / 8)
+	, mSendBlocked(false)
+	, mSrcStream(StreamStatic)
+	, mFdStream(-1)
+	, mOffStream(0)
+	, mpStream(NULL)
+	, mLenStream(0)
+	, mStreamSrcWait(false)
+	, mStats()
+	, mIsServer(false)
 {
 	mState = StCltStart;
 	mSendReady = false;
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxConnections);
+#endif
+	connections.push_back(this);
+}
+
+TcpTransfering::~TcpTransfering()
+{
+	// Never disconnected
+	if (mpSources)
+		mpSources->connRemove(mSockAddrRemote);
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxConnections);
+#endif
+	connections.remove(this);
+}
+
+/*
+ * Literature
+ * - https://www.rfc-editor.org/rfc/rfc8305#section-4
+ *
+ * Alternate the address families. Starting with
+ * the one preferred by the resolver
+ */
+static void addrsInterleave(vector<struct sockaddr_storage> &addrs, uint16_t numPort)
+{
+	vector<struct sockaddr_storage> addrsFirst, addrsSecond;
+	size_t i, j;
+
+	for (i = 0; i < addrs.size(); ++i)
+	{
+		if (addrs[i].ss_family == AF_INET)
+			((struct sockaddr_in *)&addrs[i])->sin_port = htons(numPort);
+		else
+			((struct sockaddr_in6 *)&addrs[i])->sin6_port = htons(numPort);
+
+		if (addrs[i].ss_family == addrs[0].ss_family)
+			addrsFirst.push_back(addrs[i]);
+		else
+			addrsSecond.push_back(addrs[i]);
+	}
+
+	addrs.clear();
+
+	for (i = 0, j = 0; i < addrsFirst.size() || j < addrsSecond.size();)
+	{
+		if (i < addrsFirst.size())
+			addrs.push_back(addrsFirst[i++]);
+
+		if (j < addrsSecond.size())
+			addrs.push_back(addrsSecond[j++]);
+	}
 }
 
 /*
@@ -128,8 +295,8 @@ Success TcpTransfering::process()
 {
 	uint32_t curTimeMs = millis();
 	uint32_t diffMs = curTimeMs - mStartMs;
+	struct sockaddr_storage addr;
 	Success success;
-	int res, numErr = 0;
 	ssize_t connCheck;
 #ifdef _WIN32
 	bool ok;
@@ -149,10 +316,14 @@ Success TcpTransfering::process()
 		if (mSocketFd == INVALID_SOCKET)
 			return procErrLog(-1, "socket file descriptor not set");
 
-		success = socketOptionsSet();
+		success = socketOptionsSet(mSocketFd);
 		if (success != Positive)
 			return procErrLog(-1, "could not set socket options");
 
+		mReadReady = true;
+
+		eventsRegister();
+
 		mState = StConnMain;
 
 		break;
@@ -173,78 +344,137 @@ Success TcpTransfering::process()
 		if (mHostAddrStr == "localhost")
 			mHostAddrStr = "127.0.0.1";
 
-		mpHostAddr = addrStringToSock(mHostAddrStr, mHostPort);
-		if (!mpHostAddr)
-			return procErrLog(-1, "could not parse IP address. Given: '%s'",
-					mHostAddrStr.c_str());
+		mAddrsConn.clear();
+		mIdxAddrConn = 0;
 
-		// create and configure socket
+		if (addrStringToSock(mHostAddrStr, mHostPort, addr))
+		{
+			mAddrsConn.push_back(addr);
+			mState = StCltConnStart;
+			break;
+		}
 
-		mSocketFd = socket(mpHostAddr->ss_family, SOCK_STREAM, 0);
-		if (mSocketFd == INVALID_SOCKET)
-			return procErrLog(-1, "could not create socket: %s",
-							errnoToStr(errGet()).c_str());
+		mStartMs = curTimeMs;
+		mState = StCltResolveWait;
+
+		break;
+	case StCltResolveWait:
+
+		if (diffMs > dTmoDefaultResolveMs)
+			return procErrLog(-1, "timeout resolving host");
+
+		success = dnsResolve(mHostAddrStr, mAddrsConn);
+		if (success == Pending)
+			break;
 
-		success = socketOptionsSet();
 		if (success != Positive)
-			return procErrLog(-1, "could not set socket options");
+			return procErrLog(-1, "could not resolve host. Given: '%s'",
+					mHostAddrStr.c_str());
 
-		res = connect(mSocketFd, (struct sockaddr *)mpHostAddr, sizeof(*mpHostAddr));
+		addrsInterleave(mAddrsConn, mHostPort);
 
-		free(mpHostAddr);
-		mpHostAddr = NULL;
+		mState = StCltConnStart;
 
-		if (!res)
+		break;
+	case StCltConnStart:
+
+		mStartMs = curTimeMs;
+
+		success = connAttemptStart();
+		if (success == Positive)
 		{
 			mState = StCltConnDone;
 			break;
 		}
 
-		numErr = errGet();
-#ifdef _WIN32
-		if (numErr == WSAEINPROGRESS)
-#else
-		if (numErr == EINPROGRESS)
-#endif
+		if (success == Pending)
 		{
-			mStartMs = curTimeMs;
 			mState = StCltConnDoneWait;
 			break;
 		}
 
-		return procErrLog(-1, "could not connect to host: %s (%d)",
-						errnoToStr(numErr).c_str(), numErr);
+		if (!connRetryPrepare())
+			return procErrLog(-1, "could not connect to host");
 
 		break;
 	case StCltConnDoneWait:
 
-		if (diffMs > dTmoDefaultConnDoneMs)
-			return procErrLog(-1, "timeout connecting to host");
+		if (diffMs > mTmoConnMs)
+		{
+			procDbgLog("timeout connecting to host");
+			success = -1;
+		}
+		else
+			success = connClientDone();
 
-		success = connClientDone();
 		if (success == Pending)
+		{
+			// Happy eyeballs. Next address in parallel after a delay
+			if (mIdxAddrConn >= mAddrsConn.size())
+				break;
+
+			if (mConnAttempts.size() && curTimeMs - mAttemptMs < dDelayConnAttemptMs)
+				break;
+
+			if (mConnAttempts.size() >= cNumConnAttemptsMax)
+				break;
+
+			success = connAttemptStart();
+			if (success == Pending)
+				break;
+		}
+
+		if (success == Positive)
+		{
+			mState = StCltConnDone;
 			break;
+		}
 
-		if (success != Positive)
-			return procErrLog(-1, "client connect failed");
+		if (!connRetryPrepare())
+			return procErrLog(-1, "could not connect to host");
+
+		break;
+	case StCltConnRetryWait:
+
+		if (diffMs < mDelayRetryMs)
+			break;
+
+		++mNumRetries;
 
-		mState = StCltConnDone;
+		// Addresses may have changed. Served by the cache otherwise
+		mState = StCltArgCheck;
 
 		break;
 	case StCltConnDone:
 
 		addrInfoSet();
+		mReadReady = true;
 		mSendReady = true;
 
+		eventsRegister();
+
 		mState = StConnMain;
 
 		break;
 	case StConnMain:
 
-		if (mDone)
+		sendQueueProcess();
+
+		if (mDone && !sendPending())
 			return Positive;
 
-		connCheck = read(NULL, 0);
+		// Reads since the last check delivered the connection state already
+		if (mReadDone.exchange(false))
+		{
+			connCheck = socketValid() ? 0 : -1;
+		}
+		else
+		if (!sockRingRegistered(mRecv) && sockEvtsRegistered(mEvts) &&
+				!(sockEvtsGet(mEvts) & (SockEvtHup | SockEvtErr)))
+			connCheck = 0; // Idle connection. No syscall
+		else
+			connCheck = read(NULL, 0);
+
 		if (connCheck >= 0)
 			break;
 
@@ -269,11 +499,7 @@ Success TcpTransfering::shutdown()
 {
 	procDbgLog("shutdown");
 
-	if (mpHostAddr)
-	{
-		free(mpHostAddr);
-		mpHostAddr = NULL;
-	}
+	connAttemptsClose();
 
 #if CONFIG_PROC_HAVE_DRIVERS
 	Guard lock(mSocketFdMtx);
@@ -305,6 +531,8 @@ Literature socket programming
 */
 ssize_t TcpTransfering::read(void *pBuf, size_t lenReq)
 {
+	if (readMixed(pBuf, lenReq))
+		return procErrLog(-5, "data buffered by frame read. Don't mix with read()");
 #if CONFIG_PROC_HAVE_DRIVERS
 	Guard lock(mSocketFdMtx);
 #endif
@@ -314,8 +542,16 @@ ssize_t TcpTransfering::read(void *pBuf, size_t lenReq)
 	if (mSocketFd == INVALID_SOCKET)
 		return -1;
 
+	if (sockRingRegistered(mRecv))
+		return ringRead(pBuf, lenReq);
+
+	if (sockEvtsRegistered(mEvts) &&
+			!(sockEvtsGet(mEvts) & (SockEvtRead | SockEvtHup | SockEvtErr)))
+		return 0;
+
 	ssize_t numBytes = 0;
 	bool peek = false;
+	int flags = 0;
 	char buf[1];
 
 	if (!pBuf || !lenReq)
@@ -323,18 +559,28 @@ ssize_t TcpTransfering::read(void *pBuf, size_t lenReq)
 		pBuf = buf;
 		lenReq = sizeof(buf);
 		peek = true;
+		flags = MSG_PEEK;
 	}
+	else
+		mReadDone = true;
+
+	// One syscall per read. The connection state is given by the result
 #ifdef _WIN32
-	numBytes = ::recv(mSocketFd, (char *)pBuf, (int)lenReq, MSG_PEEK);
+	numBytes = ::recv(mSocketFd, (char *)pBuf, (int)lenReq, flags);
 #else
-	numBytes = ::recv(mSocketFd, (char *)pBuf, lenReq, MSG_PEEK);
+	numBytes = ::recv(mSocketFd, (char *)pBuf, lenReq, flags);
 #endif
+	++mStats.callsRecv;
+
 	if (numBytes < 0)
 	{
 		int numErr = errGet();
 #ifdef _WIN32
 		if (numErr == WSAEWOULDBLOCK || numErr == WSAEINPROGRESS)
+		{
+			++mStats.recvAgain;
 			return 0; // std case and ok
+		}
 
 		if (numErr == WSAECONNRESET)
 		{
@@ -344,7 +590,11 @@ ssize_t TcpTransfering::read(void *pBuf, size_t lenReq)
 		}
 #else
 		if (numErr == EWOULDBLOCK || numErr == EINPROGRESS || numErr == EAGAIN)
+		{
+			++mStats.recvAgain;
+			sockEvtsClear(mEvts, SockEvtRead);
 			return 0; // std case and ok
+		}
 
 		if (numErr == ECONNRESET)
 		{
@@ -368,18 +618,60 @@ ssize_t TcpTransfering::read(void *pBuf, size_t lenReq)
 
 	if (peek)
 		return numBytes;
-#ifdef _WIN32
-	numBytes = ::recv(mSocketFd, (char *)pBuf, (int)numBytes, 0);
-#else
-	numBytes = ::recv(mSocketFd, (char *)pBuf, numBytes, 0);
+#ifdef TCP_QUICKACK
+	// Cleared by the kernel after use. Rearmed only for the
+	// response to a sent request. Bulk receives cost no syscall
+	if (mTuning.quickAck > 0 && mQuickAckRearm)
+	{
+		int opt = 1;
+		::setsockopt(mSocketFd, IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+		mQuickAckRearm = false;
+	}
 #endif
+	// Socket probably drained. Level triggered events report the rest
+	if ((size_t)numBytes < lenReq)
+		sockEvtsClear(mEvts, SockEvtRead);
+
 	//procDbgLog("received data. len: %d", numBytes);
 
-	mBytesReceived += numBytes;
+	mStats.bytesReceived += numBytes;
 
 	return numBytes;
 }
 
+// Caller must lock
+ssize_t TcpTransfering::ringRead(void *pBuf, size_t lenReq)
+{
+	ssize_t numBytes;
+	int numErr;
+
+	numBytes = sockRingRead(mRecv, pBuf, lenReq);
+	if (numBytes >= 0)
+	{
+		if (pBuf && lenReq)
+		{
+			mReadDone = true;
+			mStats.bytesReceived += numBytes;
+		}
+
+		return numBytes;
+	}
+
+	numErr = -mRecv.res;
+
+	if (!numErr || numErr == ECONNRESET)
+	{
+		procDbgLog("connection reset by peer");
+		disconnect();
+		return -4;
+	}
+
+	disconnect(numErr);
+
+	return procErrLog(-3, "recv() failed: %s",
+						errnoToStr(numErr).c_str());
+}
+
 ssize_t TcpTransfering::readFlush()
 {
 	ssize_t bytesRead = 1, bytesSum = 0;
@@ -394,7 +686,25 @@ ssize_t TcpTransfering::readFlush()
 	return bytesSum;
 }
 
+/*
+ * Data which can't be sent immediately is queued and sent
+ * as soon as the socket is writable. The queue never exceeds
+ * the maximum size given by sendQueueLimitsSet().
+ * Return: Number of bytes accepted. Less than lenReq if the queue
+ * is full. 0 while sendBlocked() is set
+ */
 ssize_t TcpTransfering::send(const void *pData, size_t lenReq)
+{
+	SendBuf buf = { pData, lenReq };
+
+	return send(&buf, 1);
+}
+
+/*
+ * Scatter/gather. The buffers are sent with a single
+ * sendmsg() instead of being concatenated first
+ */
+ssize_t TcpTransfering::send(const SendBuf *pBufs, size_t numBufs)
 {
 	if (!mSendReady)
 		return procErrLog(-1, "unable to send data. Not ready");
@@ -409,170 +719,1001 @@ ssize_t TcpTransfering::send(const void *pData, size_t lenReq)
 		return -1;
 
 	ssize_t res;
-	size_t lenBkup = lenReq;
-	size_t bytesSent = 0;
+	size_t lenPending = mBufSend.size() - mIdxBufSend;
+	size_t lenReq = 0;
+	size_t i;
+
+	for (i = 0; i < numBufs; ++i)
+		lenReq += pBufs[i].len;
 
-	while (lenReq)
+	if (lenPending)
 	{
-		/* IMPORTANT:
-		  * Connection may be reset by remote peer already.
-		  * Flag MSG_NOSIGNAL prevents function send() to
-		  * emit signal SIGPIPE and therefore kill the entire
-		  * application in this case.
-		  */
-#ifdef _WIN32
-		res = ::send(mSocketFd, (const char *)pData, (int)lenReq, MSG_NOSIGNAL);
-#else
-		res = ::send(mSocketFd, (const char *)pData, lenReq, MSG_NOSIGNAL);
-#endif
+		res = sendQueueFlush();
 		if (res < 0)
-		{
-			int numErr = errGet();
-#ifdef _WIN32
-			if (numErr == WSAEWOULDBLOCK || numErr == WSAEINPROGRESS)
-				return 0; // std case and ok
-#else
-			if (numErr == EWOULDBLOCK || numErr == EINPROGRESS || numErr == EAGAIN)
-				return 0; // std case and ok
-#endif
-			disconnect(numErr);
-
-			return procErrLog(-1, "connection down: %s",
-							errnoToStr(numErr).c_str());
-		}
+			return res;
 
-		if (!res)
-			break;
+		lenPending = mBufSend.size() - mIdxBufSend;
+	}
 
-		pData = ((const uint8_t *)pData) + res;
-		lenReq -= res;
+	if (lenPending || mLenStream)
+	{
+		if (mSendBlocked || lenPending >= mSizeSendMax)
+			return 0;
 
-		bytesSent += res;
+		// Keep the order. Queue what fits
+		return sendQueueAppend(pBufs, numBufs, 0, mSizeSendMax - lenPending);
 	}
 
-	if (bytesSent != lenBkup)
-		procWrnLog("not all data has been sent");
+	res = socketSend(pBufs, numBufs);
+	if (res < 0)
+		return res;
 
-	mBytesSent += bytesSent;
+	if ((size_t)res == lenReq)
+		return res;
 
-	return bytesSent;
+	// The rest is queued up to the maximum size
+	return res + sendQueueAppend(pBufs, numBufs, res, mSizeSendMax);
 }
 
-void TcpTransfering::disconnect(int err)
+size_t TcpTransfering::sendPending() const
 {
-#if CONFIG_PROC_HAVE_DRIVERS
-	//Guard lock(mSocketFdMtx); // every caller must lock in advance!
-#endif
-	if (mSocketFd == INVALID_SOCKET)
-	{
-		procDbgLog("socket closed already");
-		return;
-	}
-
-	procDbgLog("closing socket: %d", mSocketFd);
-	mErrno = err;
-#ifdef _WIN32
-	::closesocket(mSocketFd);
-#else
-	::close(mSocketFd);
-#endif
-	mSocketFd = INVALID_SOCKET;
-	procDbgLog("closing socket: %d: done", mSocketFd);
+	return mBufSend.size() - mIdxBufSend + mLenStream;
 }
 
-Success TcpTransfering::socketOptionsSet()
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/sendfile.2.html
+ * - https://man7.org/linux/man-pages/man2/splice.2.html
+ *
+ * The file descriptor is owned by the caller and must be
+ * kept open until sendStreamPending() returns zero
+ */
+Success TcpTransfering::fileSend(int fd, uint64_t offset, size_t len)
 {
-#if CONFIG_PROC_HAVE_DRIVERS
-	Guard lock(mSocketFdMtx);
-#endif
-	int opt;
-	int res;
-	bool ok;
-
-	opt = 1;
-	res = ::setsockopt(mSocketFd, SOL_SOCKET, SO_KEEPALIVE, (const char *)&opt, sizeof(opt));
-	if (res)
-		return procErrLog(-2, "setsockopt(SO_KEEPALIVE) failed: %s",
-							errnoToStr(errGet()).c_str());
+	return streamStart(StreamFile, fd, offset, NULL, len);
+}
 
-	ok = fileNonBlockingSet(mSocketFd);
-	if (!ok)
-		return procErrLog(-3, "could not set non blocking mode: %s",
-							errnoToStr(errGet()).c_str());
+// Linux only
+Success TcpTransfering::pipeSend(int fd, size_t len)
+{
+	return streamStart(StreamPipe, fd, 0, NULL, len);
+}
 
-	mReadReady = true;
+// The data must be kept until sendStreamPending() returns zero
+Success TcpTransfering::staticSend(const void *pData, size_t len)
+{
+	return streamStart(StreamStatic, -1, 0, (const uint8_t *)pData, len);
+}
 
-	return Positive;
+size_t TcpTransfering::sendStreamPending() const
+{
+	return mLenStream;
 }
 
-/* Literature
- * - https://man7.org/linux/man-pages/man2/connect.2.html
- * - https://man7.org/linux/man-pages/man2/select.2.html
- * - https://man7.org/linux/man-pages/man2/poll.2.html
- * - https://man7.org/linux/man-pages/man2/getsockopt.2.html
- * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-select
- * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-wsapoll
- * - https://learn.microsoft.com/en-us/windows/win32/api/winsock/nf-winsock-getsockopt
- */
-Success TcpTransfering::connClientDone()
+Success TcpTransfering::streamStart(int src, int fd, uint64_t offset, const uint8_t *pData, size_t len)
 {
-#ifdef _WIN32
-	WSAPOLLFD fds[1];
-#else
-	struct pollfd fds[1];
+	if (!mSendReady)
+		return procErrLog(-1, "unable to send data. Not ready");
+#if !CONFIG_PROC_HAVE_FILE_SEND
+	if (src != StreamStatic)
+		return procErrLog(-1, "sending files not supported");
 #endif
-	int res;
+#if !defined(__linux__)
+	if (src == StreamPipe)
+		return procErrLog(-1, "sending pipes not supported");
+#endif
+	if (src != StreamStatic && fd < 0)
+		return procErrLog(-1, "file descriptor not set");
 
-	fds[0].fd = mSocketFd;
-	fds[0].events = POLLOUT;
-#ifdef _WIN32
-	res = WSAPoll(fds, 1, 0);
-#else
-	res = poll(fds, 1, 0);
+	if (src == StreamStatic && !pData)
+		return procErrLog(-1, "data not set");
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
 #endif
-	if (!res)
+	if (mSocketFd == INVALID_SOCKET)
+		return -1;
+
+	// One stream at a time. Queued data goes first
+	if (mLenStream)
 		return Pending;
 
-	if (res < 0)
-		return procErrLog(-1, "could not poll socket: %s",
-						errnoToStr(errGet()).c_str());
+	if (sendQueueFlush() < 0)
+		return -1;
 
-	if (!(fds[0].revents & POLLOUT))
-		return procErrLog(-1, "didn't get POLLOUT event");
+	if (mIdxBufSend != mBufSend.size())
+		return Pending;
 
-	int errSock;
-#ifdef _WIN32
-	int len = sizeof(errSock);
-	res = ::getsockopt(mSocketFd, SOL_SOCKET, SO_ERROR, (char *)&errSock, &len);
-#else
-	socklen_t len = sizeof(errSock);
-	res = ::getsockopt(mSocketFd, SOL_SOCKET, SO_ERROR, &errSock, &len);
-#endif
-	if (res)
-		return procErrLog(-2, "getsockopt(SO_ERROR) failed: %s",
-							errnoToStr(errGet()).c_str());
+	if (!len)
+		return Positive;
 
-	if (errSock)
-		return procErrLog(-2, "socket error: %s",
-							errnoToStr(errSock).c_str());
+	mSrcStream = src;
+	mFdStream = fd;
+	mOffStream = offset;
+	mpStream = pData;
+	mLenStream = len;
+	mStreamSrcWait = false;
+
+	if (streamProcess() < 0)
+		return -1;
+
+	if (mLenStream && !mStreamSrcWait)
+		sockEvtsInterestSet(mEvts, mEvtsRead | SockEvtWrite);
 
 	return Positive;
 }
 
-/* Literature
- * - http://man7.org/linux/man-pages/man2/getsockname.2.html
- * - http://man7.org/linux/man-pages/man2/getpeername.2.html
- * - https://stackoverflow.com/questions/10167540/how-to-get-local-ip-address-and-port-in-unix-socket-programming
- *   - https://beej.us/guide/bgnet/html/multi/getpeernameman.html
- * - http://www.masterraghu.com/subjects/np/introduction/unix_network_programming_v1.3/ch04lev1sec10.html
- * - https://linux.die.net/man/3/inet_ntoa
- *   The inet_ntoa() function converts the Internet host address in, given in network byte order, to a string in IPv4 dotted-decimal notation.
- *   The string is returned in a statically allocated buffer, which subsequent calls will overwrite.
- */
-void TcpTransfering::addrInfoSet()
+// Caller must lock
+ssize_t TcpTransfering::streamProcess()
 {
-	if (mInfoSet)
-		return;
+	ssize_t res = 0;
+	size_t lenChunk;
+	int numErr;
+
+	while (mLenStream)
+	{
+		lenChunk = PMIN(mLenStream, cSizeStreamChunk);
+
+		if (mSrcStream == StreamStatic)
+		{
+			SendBuf buf = { mpStream, lenChunk };
+
+			res = socketSend(&buf, 1);
+			if (res < 0)
+				return res;
+
+			if (!res)
+				break;
+
+			mpStream += res;
+			mLenStream -= res;
+
+			continue;
+		}
+#if CONFIG_PROC_HAVE_FILE_SEND
+#if defined(__linux__)
+		if (mSrcStream == StreamFile)
+		{
+			off_t off = (off_t)mOffStream;
+
+			res = ::sendfile(mSocketFd, mFdStream, &off, lenChunk);
+		}
+		else
+			res = ::splice(mFdStream, NULL, mSocketFd, NULL, lenChunk,
+						SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+#else
+		uint8_t buf[cSizeStreamBuf];
+
+		lenChunk = PMIN(lenChunk, sizeof(buf));
+
+		res = ::pread(mFdStream, buf, lenChunk, (off_t)mOffStream);
+		if (res > 0)
+			res = ::send(mSocketFd, buf, res, MSG_NOSIGNAL);
+#endif
+		++mStats.callsSend;
+
+		if (res < 0)
+		{
+			numErr = errGet();
+
+			// splice() also fails if the pipe is empty. The socket
+			// stays writable in this case. Wait for the writer instead
+			if ((numErr == EWOULDBLOCK || numErr == EAGAIN) &&
+					mSrcStream == StreamPipe && !streamSrcReady())
+			{
+				mStreamSrcWait = true;
+				sockEvtsInterestSet(mEvts, mEvtsRead);
+				return 0;
+			}
+
+			if (numErr == EWOULDBLOCK || numErr == EAGAIN)
+			{
+				++mStats.sendAgain;
+				sockEvtsClear(mEvts, SockEvtWrite);
+				return 0;
+			}
+
+			mLenStream = 0;
+			disconnect(numErr);
+
+			return procErrLog(-1, "could not send file: %s",
+							errnoToStr(numErr).c_str());
+		}
+
+		if (!res)
+		{
+			// End of file or pipe closed
+			procDbgLog("stream ended early. Remaining %zu bytes", mLenStream);
+			mLenStream = 0;
+			break;
+		}
+
+		if ((size_t)res < lenChunk)
+			++mStats.sendsPartial;
+
+		mOffStream += res;
+		mLenStream -= res;
+		mStats.bytesSent += res;
+#endif
+	}
+
+	return res;
+}
+
+// Caller must lock
+bool TcpTransfering::streamSrcReady()
+{
+#ifndef _WIN32
+	struct pollfd pfd;
+
+	pfd.fd = mFdStream;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	// Data, closed writer or error
+	return ::poll(&pfd, 1, 0) != 0;
+#else
+	return true;
+#endif
+}
+
+bool TcpTransfering::sendBlocked() const
+{
+	return mSendBlocked;
+}
+
+/*
+ * Limits of the send queue
+ * - sizeMax  .. Data exceeding this size is not accepted
+ * - lenHigh  .. sendBlocked() is set when reaching this length
+ * - lenLow   .. sendBlocked() is cleared when falling to this length
+ */
+void TcpTransfering::sendQueueLimitsSet(size_t sizeMax, size_t lenHigh, size_t lenLow)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	mSizeSendMax = sizeMax;
+	mLenSendHigh = PMIN(lenHigh, sizeMax);
+	mLenSendLow = PMIN(lenLow, mLenSendHigh);
+}
+
+// Caller must lock
+void TcpTransfering::sendQueueAppend(const void *pData, size_t len)
+{
+	if (!len)
+		return;
+
+	// Compact lazily
+	if (mIdxBufSend && mIdxBufSend >= mBufSend.size() / 2)
+	{
+		mBufSend.erase(mBufSend.begin(), mBufSend.begin() + mIdxBufSend);
+		mIdxBufSend = 0;
+	}
+
+	mBufSend.insert(mBufSend.end(), (const uint8_t *)pData, (const uint8_t *)pData + len);
+
+	size_t lenPending = mBufSend.size() - mIdxBufSend;
+
+	if (lenPending > mStats.lenSendQueueMax)
+		mStats.lenSendQueueMax = lenPending;
+
+	if (lenPending >= mLenSendHigh)
+		mSendBlocked = true;
+
+	sockEvtsInterestSet(mEvts, mEvtsRead | SockEvtWrite);
+}
+
+/*
+ * Caller must lock
+ * Queues the buffers starting at byte offset lenSkip, at most lenMax bytes
+ * Return: Number of bytes queued
+ */
+size_t TcpTransfering::sendQueueAppend(const SendBuf *pBufs, size_t numBufs, size_t lenSkip, size_t lenMax)
+{
+	size_t lenQueued = 0;
+	size_t len;
+
+	for (size_t i = 0; i < numBufs && lenQueued < lenMax; ++i)
+	{
+		if (lenSkip >= pBufs[i].len)
+		{
+			lenSkip -= pBufs[i].len;
+			continue;
+		}
+
+		len = PMIN(pBufs[i].len - lenSkip, lenMax - lenQueued);
+
+		sendQueueAppend((const uint8_t *)pBufs[i].pData + lenSkip, len);
+
+		lenQueued += len;
+		lenSkip = 0;
+	}
+
+	return lenQueued;
+}
+
+// Caller must lock
+ssize_t TcpTransfering::sendQueueFlush()
+{
+	size_t lenPending = mBufSend.size() - mIdxBufSend;
+	ssize_t res;
+
+	// Data queued during a stream is sent afterwards
+	if (!lenPending || mLenStream)
+		return 0;
+
+	SendBuf buf = { mBufSend.data() + mIdxBufSend, lenPending };
+
+	res = socketSend(&buf, 1);
+	if (res <= 0)
+		return res;
+
+	mIdxBufSend += res;
+	lenPending -= res;
+
+	if (lenPending <= mLenSendLow)
+		mSendBlocked = false;
+
+	if (lenPending)
+		return res;
+
+	mBufSend.clear();
+	mIdxBufSend = 0;
+
+	sockEvtsInterestSet(mEvts, mEvtsRead);
+	sockEvtsClear(mEvts, SockEvtWrite);
+
+	return res;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/sendmsg.2.html
+ * - https://man7.org/linux/man-pages/man3/iovec.3type.html
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-wsasend
+ *
+ * Return: Bytes sent. Stops when the socket is not writable
+ */
+ssize_t TcpTransfering::socketSend(const SendBuf *pBufs, size_t numBufs)
+{
+#ifdef _WIN32
+	WSABUF vec[cNumSendBufsMax];
+	DWORD lenSent;
+#else
+	struct iovec vec[cNumSendBufsMax];
+	struct msghdr msg;
+#endif
+	size_t idxBuf = 0, offBuf = 0;
+	size_t numVec, i;
+	size_t bytesSent = 0;
+	size_t lenOffered;
+	ssize_t res;
+
+	while (1)
+	{
+		// Skip finished buffers
+		while (idxBuf < numBufs && offBuf >= pBufs[idxBuf].len)
+		{
+			offBuf = 0;
+			++idxBuf;
+		}
+
+		if (idxBuf >= numBufs)
+			break;
+
+		numVec = PMIN(numBufs - idxBuf, cNumSendBufsMax);
+		lenOffered = 0;
+
+		for (i = 0; i < numVec; ++i)
+		{
+			const SendBuf &buf = pBufs[idxBuf + i];
+			size_t off = i ? 0 : offBuf;
+
+			lenOffered += buf.len - off;
+#ifdef _WIN32
+			vec[i].buf = (CHAR *)buf.pData + off;
+			vec[i].len = (ULONG)(buf.len - off);
+#else
+			vec[i].iov_base = (uint8_t *)buf.pData + off;
+			vec[i].iov_len = buf.len - off;
+#endif
+		}
+
+		/* IMPORTANT:
+		  * Connection may be reset by remote peer already.
+		  * Flag MSG_NOSIGNAL prevents function send() to
+		  * emit signal SIGPIPE and therefore kill the entire
+		  * application in this case.
+		  */
+#ifdef _WIN32
+		lenSent = 0;
+		res = ::WSASend(mSocketFd, vec, (DWORD)numVec, &lenSent, 0, NULL, NULL);
+		if (!res)
+			res = (ssize_t)lenSent;
+#else
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = vec;
+		msg.msg_iovlen = numVec;
+
+		res = ::sendmsg(mSocketFd, &msg, MSG_NOSIGNAL);
+#endif
+		++mStats.callsSend;
+
+		if (res < 0)
+		{
+			int numErr = errGet();
+#ifdef _WIN32
+			if (numErr == WSAEWOULDBLOCK || numErr == WSAEINPROGRESS)
+			{
+				++mStats.sendAgain;
+				break; // std case and ok
+			}
+#else
+			if (numErr == EWOULDBLOCK || numErr == EINPROGRESS || numErr == EAGAIN)
+			{
+				++mStats.sendAgain;
+				sockEvtsClear(mEvts, SockEvtWrite);
+				break; // std case and ok
+			}
+#endif
+			disconnect(numErr);
+
+			return procErrLog(-1, "connection down: %s",
+							errnoToStr(numErr).c_str());
+		}
+
+		if (!res)
+			break;
+
+		if ((size_t)res < lenOffered)
+			++mStats.sendsPartial;
+
+		bytesSent += res;
+		mQuickAckRearm = true;
+
+		// Advance
+		while (res && idxBuf < numBufs)
+		{
+			size_t lenRemaining = pBufs[idxBuf].len - offBuf;
+
+			if ((size_t)res < lenRemaining)
+			{
+				offBuf += res;
+				break;
+			}
+
+			res -= lenRemaining;
+			offBuf = 0;
+			++idxBuf;
+		}
+	}
+
+	mStats.bytesSent += bytesSent;
+
+	return bytesSent;
+}
+
+void TcpTransfering::sendQueueProcess()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (mSocketFd == INVALID_SOCKET)
+		return;
+
+	if (!mLenStream && mIdxBufSend == mBufSend.size())
+		return;
+
+	if (mLenStream && mStreamSrcWait)
+	{
+		// Pipe is checked every tick. Socket was writable
+		if (!streamSrcReady())
+			return;
+
+		mStreamSrcWait = false;
+		sockEvtsInterestSet(mEvts, mEvtsRead | SockEvtWrite);
+	}
+	// Without socket events we try every tick
+	else if (sockEvtsRegistered(mEvts) && !(sockEvtsGet(mEvts) & (SockEvtWrite | SockEvtErr)))
+		return;
+
+	if (mLenStream)
+	{
+		if (streamProcess() < 0 || mLenStream)
+			return;
+
+		if (mIdxBufSend == mBufSend.size())
+			sockEvtsInterestSet(mEvts, mEvtsRead);
+	}
+
+	sendQueueFlush();
+}
+
+bool TcpTransfering::socketValid()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	return mSocketFd != INVALID_SOCKET;
+}
+
+// Called in the driver of this process
+void TcpTransfering::eventsRegister()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (mSocketFd == INVALID_SOCKET)
+		return;
+
+	mEvtsRead = SockEvtRead;
+
+	// Data is delivered by the ring. Completions are reaped
+	// without a syscall. Socket events for sending only
+	if (sockRingRegister(mRecv, mSocketFd))
+		mEvtsRead = 0;
+
+	if (!sockEvtsRegister(mEvts, mSocketFd, mEvtsRead))
+		procDbgLog("socket events not available. Polling socket");
+}
+
+void TcpTransfering::disconnect(int err)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	//Guard lock(mSocketFdMtx); // every caller must lock in advance!
+#endif
+	if (mSocketFd == INVALID_SOCKET)
+	{
+		procDbgLog("socket closed already");
+		return;
+	}
+
+	procDbgLog("closing socket: %d", mSocketFd);
+	mErrno = err;
+
+	sockRingUnregister(mRecv);
+	sockEvtsUnregister(mEvts);
+
+	mBufSend.clear();
+	mIdxBufSend = 0;
+	mSendBlocked = false;
+	mLenStream = 0;
+
+#ifdef _WIN32
+	::closesocket(mSocketFd);
+#else
+	::close(mSocketFd);
+#endif
+	mSocketFd = INVALID_SOCKET;
+	procDbgLog("closing socket: %d: done", mSocketFd);
+
+	if (mpSources)
+		mpSources->connRemove(mSockAddrRemote);
+	mpSources = NULL;
+}
+
+// Socket not shared yet. No lock needed
+Success TcpTransfering::socketOptionsSet(SOCKET fd)
+{
+	int opt;
+	int res;
+	bool ok;
+	const char *pOpt;
+
+	opt = 1;
+	res = ::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, (const char *)&opt, sizeof(opt));
+	if (res)
+		return procErrLog(-2, "setsockopt(SO_KEEPALIVE) failed: %s",
+							errnoToStr(errGet()).c_str());
+
+	pOpt = tuningApply(fd, mTuning);
+	if (pOpt)
+		return procErrLog(-2, "setsockopt(%s) failed: %s",
+							pOpt, errnoToStr(errGet()).c_str());
+
+	if (mFastOpen && !mIsServer)
+	{
+#ifdef TCP_FASTOPEN_CONNECT
+		// Not fatal. Regular handshake otherwise
+		opt = 1;
+		res = ::setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, (const char *)&opt, sizeof(opt));
+		if (res)
+			procWrnLog("setsockopt(TCP_FASTOPEN_CONNECT) failed: %s",
+							errnoToStr(errGet()).c_str());
+#else
+		procWrnLog("fast open not supported");
+#endif
+	}
+
+	// Accepted with the flags already
+	if (mNonBlocking)
+		return Positive;
+
+	ok = fileNonBlockingSet(fd);
+	if (!ok)
+		return procErrLog(-3, "could not set non blocking mode: %s",
+							errnoToStr(errGet()).c_str());
+
+	return Positive;
+}
+
+// Must be called before the connection is started
+void TcpTransfering::tuningSet(const TcpTuning &tuning)
+{
+	mTuning = tuning;
+}
+
+// Per connection round. All addresses
+void TcpTransfering::connTimeoutSet(uint32_t tmoMs)
+{
+	mTmoConnMs = tmoMs;
+}
+
+void TcpTransfering::connRetriesSet(uint32_t numRetries,
+						uint32_t backoffMinMs,
+						uint32_t backoffMaxMs)
+{
+	mNumRetriesMax = numRetries;
+	mBackoffMinMs = backoffMinMs ? backoffMinMs : 1;
+	mBackoffMaxMs = backoffMaxMs > mBackoffMinMs ? backoffMaxMs : mBackoffMinMs;
+}
+
+/*
+ * Literature
+ * - https://www.rfc-editor.org/rfc/rfc7413
+ * - https://lwn.net/Articles/508865/
+ *
+ * Client side of TCP Fast Open. Linux only. connect() returns
+ * immediately and the SYN is sent with the first data. With a
+ * cookie of an earlier connection the data needs no extra round
+ * trip. Connection errors are reported by the first read or send
+ * then. Address fallback and retries don't apply anymore.
+ * The server side is enabled by TcpListening::fastOpenSet()
+ */
+void TcpTransfering::fastOpenSet(bool enable)
+{
+	mFastOpen = enable;
+}
+
+// Consistent snapshot. Also callable from other threads
+void TcpTransfering::statsGet(TcpStats &stats)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	stats = mStats;
+#if defined(__linux__) && defined(TCP_INFO)
+	if (mSocketFd == INVALID_SOCKET)
+		return;
+
+	struct tcp_info info;
+	socklen_t len = sizeof(info);
+	int res;
+
+	memset(&info, 0, sizeof(info));
+
+	res = ::getsockopt(mSocketFd, IPPROTO_TCP, TCP_INFO, &info, &len);
+	if (res)
+		return;
+
+	stats.rttUs = info.tcpi_rtt;
+	stats.rttVarUs = info.tcpi_rttvar;
+	stats.retransmits = info.tcpi_total_retrans;
+	stats.cwnd = info.tcpi_snd_cwnd;
+#endif
+}
+
+// Address strings are created on first use
+const string &TcpTransfering::addrRemote() const
+{
+	const_cast<TcpTransfering *>(this)->addrInfoSet();
+	return mAddrRemote;
+}
+
+uint16_t TcpTransfering::portRemote() const
+{
+	const_cast<TcpTransfering *>(this)->addrInfoSet();
+	return mPortRemote;
+}
+
+// Host and port given on creation. Empty for accepted connections
+const string &TcpTransfering::hostAddr() const
+{
+	return mHostAddrStr;
+}
+
+uint16_t TcpTransfering::hostPort() const
+{
+	return mHostPort;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/tcp.7.html
+ *   TCP_CORK
+ * - https://man.freebsd.org/cgi/man.cgi?query=tcp&sektion=4
+ *   TCP_NOPUSH
+ *
+ * Collects multi-part sends into full segments until uncorked.
+ * No effect on other systems
+ */
+void TcpTransfering::corkSet(bool corked)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (mSocketFd == INVALID_SOCKET)
+		return;
+
+	int opt = corked ? 1 : 0;
+	int res = 0;
+#if defined(TCP_CORK)
+	res = ::setsockopt(mSocketFd, IPPROTO_TCP, TCP_CORK, &opt, sizeof(opt));
+#elif defined(TCP_NOPUSH)
+	res = ::setsockopt(mSocketFd, IPPROTO_TCP, TCP_NOPUSH, &opt, sizeof(opt));
+#else
+	(void)opt;
+#endif
+	if (res)
+		procWrnLog("could not set cork: %s", errnoToStr(errGet()).c_str());
+}
+
+/* Literature
+ * - https://man7.org/linux/man-pages/man2/connect.2.html
+ * - https://man7.org/linux/man-pages/man2/select.2.html
+ * - https://man7.org/linux/man-pages/man2/poll.2.html
+ * - https://man7.org/linux/man-pages/man2/getsockopt.2.html
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-select
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-wsapoll
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock/nf-winsock-getsockopt
+ */
+Success TcpTransfering::connAttemptStart()
+{
+	struct sockaddr_storage *pAddr;
+	socklen_t lenAddr;
+	Success success;
+	SOCKET fd;
+	int res, numErr;
+
+	while (mIdxAddrConn < mAddrsConn.size())
+	{
+		pAddr = &mAddrsConn[mIdxAddrConn++];
+
+		// Failures only concern this address. Attempts in
+		// progress and the remaining addresses are kept
+		fd = ::socket(pAddr->ss_family, SOCK_STREAM, 0);
+		if (fd == INVALID_SOCKET)
+		{
+			procWrnLog("could not create socket: %s",
+							errnoToStr(errGet()).c_str());
+			continue;
+		}
+
+		success = socketOptionsSet(fd);
+		if (success != Positive)
+		{
+			procWrnLog("could not set socket options");
+			socketClose(fd);
+			continue;
+		}
+
+		// Important for MacOS
+		if (pAddr->ss_family == AF_INET)
+			lenAddr = sizeof(struct sockaddr_in);
+		else
+			lenAddr = sizeof(struct sockaddr_in6);
+
+		res = ::connect(fd, (struct sockaddr *)pAddr, lenAddr);
+		if (!res)
+		{
+			connAttemptsClose();
+#if CONFIG_PROC_HAVE_DRIVERS
+			Guard lock(mSocketFdMtx);
+#endif
+			mSocketFd = fd;
+			return Positive;
+		}
+
+		numErr = errGet();
+#ifdef _WIN32
+		if (numErr == WSAEWOULDBLOCK || numErr == WSAEINPROGRESS)
+#else
+		if (numErr == EINPROGRESS)
+#endif
+		{
+			mConnAttempts.emplace_back();
+
+			ConnAttempt &attempt = mConnAttempts.back();
+
+			attempt.fd = fd;
+
+			// Registration reports the interest as pending. Not valid here
+			if (sockEvtsRegister(attempt.evts, fd, SockEvtWrite))
+				sockEvtsClear(attempt.evts, SockEvtWrite);
+
+			mAttemptMs = millis();
+			return Pending;
+		}
+
+		procDbgLog("could not connect to address: %s (%d)",
+						errnoToStr(numErr).c_str(), numErr);
+		socketClose(fd);
+	}
+
+	return mConnAttempts.size() ? Pending : -1;
+}
+
+/* Literature
+ * - https://man7.org/linux/man-pages/man2/connect.2.html
+ * - https://man7.org/linux/man-pages/man2/select.2.html
+ * - https://man7.org/linux/man-pages/man2/poll.2.html
+ * - https://man7.org/linux/man-pages/man2/getsockopt.2.html
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-select
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock2/nf-winsock2-wsapoll
+ * - https://learn.microsoft.com/en-us/windows/win32/api/winsock/nf-winsock-getsockopt
+ * - https://www.rfc-editor.org/rfc/rfc8305
+ *
+ * The first successful attempt wins. The others are closed.
+ * Attempts are only checked when the reactor reported them
+ */
+Success TcpTransfering::connClientDone()
+{
+	list<ConnAttempt>::iterator iter;
+	uint32_t evts;
+	SOCKET fd;
+	int errSock;
+	int res;
+
+	iter = mConnAttempts.begin();
+	while (iter != mConnAttempts.end())
+	{
+		if (sockEvtsRegistered(iter->evts))
+			evts = sockEvtsGet(iter->evts);
+		else
+		{
+#ifdef _WIN32
+			WSAPOLLFD fdPoll;
+#else
+			struct pollfd fdPoll;
+#endif
+			fdPoll.fd = iter->fd;
+			fdPoll.events = POLLOUT;
+			fdPoll.revents = 0;
+#ifdef _WIN32
+			res = WSAPoll(&fdPoll, 1, 0);
+#else
+			res = poll(&fdPoll, 1, 0);
+#endif
+			if (res < 0)
+				return procErrLog(-1, "could not poll socket: %s",
+								errnoToStr(errGet()).c_str());
+
+			evts = 0;
+
+			if (fdPoll.revents & POLLOUT)
+				evts |= SockEvtWrite;
+
+			if (fdPoll.revents & ~POLLOUT)
+				evts |= SockEvtErr;
+		}
+
+		if (!(evts & (SockEvtWrite | SockEvtHup | SockEvtErr)))
+		{
+			++iter;
+			continue;
+		}
+
+		errSock = 0;
+#ifdef _WIN32
+		int len = sizeof(errSock);
+		res = ::getsockopt(iter->fd, SOL_SOCKET, SO_ERROR, (char *)&errSock, &len);
+#else
+		socklen_t len = sizeof(errSock);
+		res = ::getsockopt(iter->fd, SOL_SOCKET, SO_ERROR, &errSock, &len);
+#endif
+		if (res)
+			errSock = errGet();
+
+		// Registered again with the connection events
+		sockEvtsUnregister(iter->evts);
+
+		if (!errSock && (evts & SockEvtWrite))
+		{
+			fd = iter->fd;
+			mConnAttempts.erase(iter);
+
+			connAttemptsClose();
+#if CONFIG_PROC_HAVE_DRIVERS
+			Guard lock(mSocketFdMtx);
+#endif
+			mSocketFd = fd;
+
+			return Positive;
+		}
+
+		procDbgLog("connect attempt failed: %s",
+					errnoToStr(errSock).c_str());
+
+		socketClose(iter->fd);
+		iter = mConnAttempts.erase(iter);
+	}
+
+	if (mConnAttempts.size() || mIdxAddrConn < mAddrsConn.size())
+		return Pending;
+
+	return procErrLog(-2, "could not connect to host");
+}
+
+void TcpTransfering::connAttemptsClose()
+{
+	list<ConnAttempt>::iterator iter;
+
+	for (iter = mConnAttempts.begin(); iter != mConnAttempts.end(); ++iter)
+	{
+		sockEvtsUnregister(iter->evts);
+		socketClose(iter->fd);
+	}
+
+	mConnAttempts.clear();
+}
+
+/*
+ * Literature
+ * - https://aws.amazon.com/blogs/architecture/exponential-backoff-and-jitter/
+ *
+ * Exponential backoff with jitter. Clients of a restarted
+ * backend don't reconnect at the same time.
+ * Return value: false if no retries are left
+ */
+bool TcpTransfering::connRetryPrepare()
+{
+	static thread_local minstd_rand rng((uint32_t)steady_clock::now().time_since_epoch().count());
+	uint32_t delayMs = mBackoffMinMs;
+	uint32_t i;
+
+	connAttemptsClose();
+
+	if (mNumRetries >= mNumRetriesMax)
+		return false;
+
+	for (i = 0; i < mNumRetries && delayMs < mBackoffMaxMs; ++i)
+		delayMs <<= 1;
+
+	if (delayMs > mBackoffMaxMs)
+		delayMs = mBackoffMaxMs;
+
+	mDelayRetryMs = delayMs / 2 + rng() % (delayMs / 2 + 1);
+
+	procDbgLog("connect retry %u of %u in %ums",
+				mNumRetries + 1, mNumRetriesMax, mDelayRetryMs);
+
+	mStartMs = millis();
+	mState = StCltConnRetryWait;
+
+	return true;
+}
+
+/* Literature
+ * - http://man7.org/linux/man-pages/man2/getsockname.2.html
+ * - http://man7.org/linux/man-pages/man2/getpeername.2.html
+ * - https://stackoverflow.com/questions/10167540/how-to-get-local-ip-address-and-port-in-unix-socket-programming
+ *   - https://beej.us/guide/bgnet/html/multi/getpeernameman.html
+ * - http://www.masterraghu.com/subjects/np/introduction/unix_network_programming_v1.3/ch04lev1sec10.html
+ * - https://linux.die.net/man/3/inet_ntoa
+ *   The inet_ntoa() function converts the Internet host address in, given in network byte order, to a string in IPv4 dotted-decimal notation.
+ *   The string is returned in a statically allocated buffer, which subsequent calls will overwrite.
+ *
+ * Called on demand. The peer address of accepted
+ * connections is known already
+ */
+// Published under the lock. Read by statsListStr() of other threads
+void TcpTransfering::addrInfoSet()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (mInfoSet)
+		return;
 
 	if (mSocketFd == INVALID_SOCKET)
 		return;
@@ -602,7 +1743,10 @@ void TcpTransfering::addrInfoSet()
 	memset(&addr, 0, sizeof(addr));
 	addrLen = sizeof(addr);
 
-	res = ::getpeername(mSocketFd, (struct sockaddr *)&addr, &addrLen);
+	if (mSockAddrRemote.ss_family)
+		addr = mSockAddrRemote;
+	else
+		res = ::getpeername(mSocketFd, (struct sockaddr *)&addr, &addrLen);
 #ifdef _WIN32
 	if (res == SOCKET_ERROR)
 		return;
@@ -614,19 +1758,16 @@ void TcpTransfering::addrInfoSet()
 	if (!ok)
 		return;
 
+	mSockAddrRemote = addr;
 	mInfoSet = true;
 }
 
-struct sockaddr_storage *TcpTransfering::addrStringToSock(const string &strAddr, uint16_t numPort)
+bool TcpTransfering::addrStringToSock(const string &strAddr, uint16_t numPort, struct sockaddr_storage &addr)
 {
-	struct sockaddr_storage *pAddr;
-
-	pAddr = (struct sockaddr_storage *)calloc(1, sizeof(struct sockaddr_storage));
-	if (!pAddr)
-		return NULL;
+	struct sockaddr_in *pAddr4 = (struct sockaddr_in *)&addr;
+	struct sockaddr_in6 *pAddr6 = (struct sockaddr_in6 *)&addr;
 
-	struct sockaddr_in *pAddr4 = (struct sockaddr_in *)pAddr;
-	struct sockaddr_in6 *pAddr6 = (struct sockaddr_in6 *)pAddr;
+	memset(&addr, 0, sizeof(addr));
 
 	if (inet_pton(AF_INET, strAddr.c_str(), &pAddr4->sin_addr) == 1)
 	{
@@ -640,12 +1781,9 @@ struct sockaddr_storage *TcpTransfering::addrStringToSock(const string &strAddr,
 		pAddr6->sin6_port = htons(numPort);
 	}
 	else
-	{
-		free(pAddr);
-		return NULL;
-	}
+		return false;
 
-	return pAddr;
+	return true;
 }
 
 int TcpTransfering::errGet()
@@ -686,7 +1824,18 @@ string TcpTransfering::errnoToStr(int num)
 void TcpTransfering::processInfo(char *pBuf, char *pBufEnd)
 {
 	//dInfo("State\t\t\t%s\n", ProcStateString[mState]);
-	dInfo("Bytes received\t\t%d\n", (int)mBytesReceived);
+	dInfo("Bytes received\t\t%d\n", (int)mStats.bytesReceived);
+	dInfo("Bytes sent\t\t%d\n", (int)mStats.bytesSent);
+	dInfo("Syscalls\t\t%u recv, %u send\n", mStats.callsRecv, mStats.callsSend);
+	dInfo("Bytes queued\t\t%d%s\n", (int)sendPending(), mSendBlocked ? " (blocked)" : "");
+	if (mLenStream)
+		dInfo("Bytes streamed\t\t%d pending\n", (int)mLenStream);
+	if (mNumRetries)
+		dInfo("Connect retries\t\t%u of %u\n", mNumRetries, mNumRetriesMax);
+	if (mFastOpen && !mIsServer)
+		dInfo("Fast open\n");
+
+	addrInfoSet();
 
 	if (!mInfoSet)
 		return;
@@ -709,6 +1858,146 @@ void TcpTransfering::processInfo(char *pBuf, char *pBufEnd)
 
 /* static functions */
 
+void TcpStats::add(const TcpStats &other)
+{
+	bytesReceived += other.bytesReceived;
+	bytesSent += other.bytesSent;
+	callsRecv += other.callsRecv;
+	callsSend += other.callsSend;
+	recvAgain += other.recvAgain;
+	sendAgain += other.sendAgain;
+	sendsPartial += other.sendsPartial;
+	retransmits += other.retransmits;
+
+	if (other.lenSendQueueMax > lenSendQueueMax)
+		lenSendQueueMax = other.lenSendQueueMax;
+
+	if (other.rttUs > rttUs)
+		rttUs = other.rttUs;
+}
+
+struct ConnStatsEntry
+{
+	TcpStats stats;
+	std::string addr;
+	uint16_t port;
+	uint16_t portLocal;
+	bool isServer;
+};
+
+static bool connStatsSort(const ConnStatsEntry &first, const ConnStatsEntry &second)
+{
+	return first.stats.rttUs > second.stats.rttUs;
+}
+
+/*
+ * Totals, totals of accepted connections by local port
+ * and the connections with the highest RTT
+ */
+size_t TcpTransfering::statsListStr(char *pBuf, char *pBufEnd, size_t numConnMax)
+{
+	char *pBufStart = pBuf;
+	vector<ConnStatsEntry> entries;
+	vector<ConnStatsEntry>::iterator iter;
+	list<TcpTransfering *>::iterator iterConn;
+	TcpStats total;
+	size_t i;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mtxConnections);
+#endif
+		entries.reserve(connections.size());
+
+		for (iterConn = connections.begin(); iterConn != connections.end(); ++iterConn)
+		{
+			TcpTransfering *pConn = *iterConn;
+			ConnStatsEntry entry;
+
+			struct sockaddr_storage addr;
+			bool isIPv6;
+
+			pConn->statsGet(entry.stats);
+
+			entry.port = 0;
+			entry.isServer = pConn->mIsServer;
+			{
+				// Address strings of other connections are written lazily
+#if CONFIG_PROC_HAVE_DRIVERS
+				Guard lockConn(pConn->mSocketFdMtx);
+#endif
+				addr = pConn->mSockAddrRemote;
+				entry.portLocal = pConn->mPortLocal;
+			}
+
+			if (addr.ss_family)
+				sockaddrInfoGet(addr, entry.addr, entry.port, isIPv6);
+
+			entries.push_back(entry);
+		}
+	}
+
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
+		total.add(iter->stats);
+
+	dInfo("Connections %zu, max RTT %u.%03ums, %u retransmits\n",
+			entries.size(), total.rttUs / 1000, total.rttUs % 1000,
+			total.retransmits);
+	dInfo("Bytes %zu / %zu, calls %u / %u, again %u / %u, partial %u\n",
+			total.bytesReceived, total.bytesSent,
+			total.callsRecv, total.callsSend,
+			total.recvAgain, total.sendAgain,
+			total.sendsPartial);
+
+	sort(entries.begin(), entries.end(), connStatsSort);
+
+	// Listeners
+	for (i = 0; i < entries.size(); ++i)
+	{
+		uint16_t portLocal = entries[i].portLocal;
+		TcpStats totalPort;
+		size_t numConn = 0, k;
+
+		if (!entries[i].isServer || !portLocal)
+			continue;
+
+		for (k = 0; k < i; ++k)
+		{
+			if (entries[k].isServer && entries[k].portLocal == portLocal)
+				break;
+		}
+
+		if (k < i)
+			continue; // Listed already
+
+		for (k = i; k < entries.size(); ++k)
+		{
+			if (!entries[k].isServer || entries[k].portLocal != portLocal)
+				continue;
+
+			totalPort.add(entries[k].stats);
+			++numConn;
+		}
+
+		dInfo("Port %u: %zu conn, max RTT %u.%03ums, %u retransmits\n",
+				portLocal, numConn,
+				totalPort.rttUs / 1000, totalPort.rttUs % 1000,
+				totalPort.retransmits);
+	}
+
+	for (i = 0; i < entries.size() && i < numConnMax; ++i)
+	{
+		const ConnStatsEntry &entry = entries[i];
+
+		dInfo("%s:%u RTT %u.%03ums +-%u.%03u, retr %u, q %zu\n",
+				entry.addr.c_str(), entry.port,
+				entry.stats.rttUs / 1000, entry.stats.rttUs % 1000,
+				entry.stats.rttVarUs / 1000, entry.stats.rttVarUs % 1000,
+				entry.stats.retransmits, entry.stats.lenSendQueueMax);
+	}
+
+	return pBuf - pBufStart;
+}
+
 bool TcpTransfering::sockaddrInfoGet(struct sockaddr_storage &addr,
 								string &strAddr,
 								uint16_t &numPort,
@@ -752,6 +2041,63 @@ uint32_t TcpTransfering::millis()
 	return (uint32_t)nowMs.time_since_epoch().count();
 }
 
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/tcp.7.html
+ * - https://man7.org/linux/man-pages/man7/socket.7.html
+ * - https://learn.microsoft.com/en-us/windows/win32/winsock/ipproto-tcp-socket-options
+ *
+ * Also used for accepted sockets of TcpListening.
+ * Return value: Name of the failed option or NULL
+ */
+#define dOptSet(lvl, name, val) \
+	do { \
+		int opt = val; \
+		if (::setsockopt(fd, lvl, name, (const char *)&opt, sizeof(opt))) \
+			return #name; \
+	} while (0)
+
+const char *TcpTransfering::tuningApply(SOCKET fd, const TcpTuning &tuning)
+{
+	if (tuning.noDelay >= 0)
+		dOptSet(IPPROTO_TCP, TCP_NODELAY, tuning.noDelay ? 1 : 0);
+#ifdef TCP_QUICKACK
+	if (tuning.quickAck >= 0)
+		dOptSet(IPPROTO_TCP, TCP_QUICKACK, tuning.quickAck ? 1 : 0);
+#endif
+	if (tuning.sizeBufSend >= 0)
+		dOptSet(SOL_SOCKET, SO_SNDBUF, tuning.sizeBufSend);
+
+	if (tuning.sizeBufRecv >= 0)
+		dOptSet(SOL_SOCKET, SO_RCVBUF, tuning.sizeBufRecv);
+#if defined(TCP_KEEPIDLE)
+	if (tuning.keepAliveIdleSec >= 0)
+		dOptSet(IPPROTO_TCP, TCP_KEEPIDLE, tuning.keepAliveIdleSec);
+#elif defined(TCP_KEEPALIVE)
+	if (tuning.keepAliveIdleSec >= 0)
+		dOptSet(IPPROTO_TCP, TCP_KEEPALIVE, tuning.keepAliveIdleSec);
+#endif
+#ifdef TCP_KEEPINTVL
+	if (tuning.keepAliveIntervalSec >= 0)
+		dOptSet(IPPROTO_TCP, TCP_KEEPINTVL, tuning.keepAliveIntervalSec);
+#endif
+#ifdef TCP_KEEPCNT
+	if (tuning.keepAliveCount >= 0)
+		dOptSet(IPPROTO_TCP, TCP_KEEPCNT, tuning.keepAliveCount);
+#endif
+#ifdef TCP_USER_TIMEOUT
+	if (tuning.userTimeoutMs >= 0)
+		dOptSet(IPPROTO_TCP, TCP_USER_TIMEOUT, tuning.userTimeoutMs);
+#endif
+#ifdef SO_BUSY_POLL
+	if (tuning.busyPollUs >= 0)
+		dOptSet(SOL_SOCKET, SO_BUSY_POLL, tuning.busyPollUs);
+#endif
+	return NULL;
+}
+
+#undef dOptSet
+
 bool TcpTransfering::fileNonBlockingSet(SOCKET fd)
 {
 	int opt;
@@ -775,6 +2121,17 @@ bool TcpTransfering::fileNonBlockingSet(SOCKET fd)
 	return true;
 }
 
+void TcpTransfering::socketClose(SOCKET fd)
+{
+	if (fd == INVALID_SOCKET)
+		return;
+#ifdef _WIN32
+	::closesocket(fd);
+#else
+	::close(fd);
+#endif
+}
+
 #ifdef _WIN32
 bool TcpTransfering::wsaInit()
 {
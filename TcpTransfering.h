@@ -32,6 +32,8 @@
 #define TCP_TRANSFERING_H
 
 #include <string>
+#include <list>
+#include <atomic>
 
 #ifdef _WIN32
 // https://learn.microsoft.com/en-us/cpp/porting/modifying-winver-and-win32-winnt?view=msvc-170
@@ -58,6 +60,18 @@
  * - https://handsonnetworkprogramming.com/articles/differences-windows-winsock-linux-unix-bsd-sockets-compatibility/
  * - https://handsonnetworkprogramming.com/articles/socket-function-return-value-windows-linux-macos/
  */
+#ifndef CONFIG_PROC_TCP_SIZE_SEND_QUEUE
+#define CONFIG_PROC_TCP_SIZE_SEND_QUEUE		(256 * 1024)
+#endif
+
+#ifndef CONFIG_PROC_HAVE_FILE_SEND
+#if defined(__unix__) || defined(__APPLE__)
+#define CONFIG_PROC_HAVE_FILE_SEND			1
+#else
+#define CONFIG_PROC_HAVE_FILE_SEND			0
+#endif
+#endif
+
 #ifndef _WIN32
 #ifndef SOCKET
 #define SOCKET int
@@ -66,6 +80,119 @@
 #endif
 
 #include "Transfering.h"
+#include "SocketEvents.h"
+#include "SocketRing.h"
+
+/*
+ * Values < 0 keep the system default
+ *
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/tcp.7.html
+ * - https://man7.org/linux/man-pages/man7/socket.7.html
+ */
+struct TcpTuning
+{
+	TcpTuning()
+		: noDelay(-1)
+		, quickAck(-1)
+		, sizeBufSend(-1)
+		, sizeBufRecv(-1)
+		, keepAliveIdleSec(-1)
+		, keepAliveIntervalSec(-1)
+		, keepAliveCount(-1)
+		, userTimeoutMs(-1)
+		, busyPollUs(-1)
+	{}
+
+	int noDelay;
+	int quickAck; // Linux. Rearmed by the first read after a send. One syscall each
+	int sizeBufSend;
+	int sizeBufRecv;
+	int keepAliveIdleSec;
+	int keepAliveIntervalSec;
+	int keepAliveCount;
+	int userTimeoutMs; // Linux
+	int busyPollUs; // Linux
+};
+
+/*
+ * Counters are updated by the connection itself.
+ * TCP_INFO values are fetched on request only
+ *
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/tcp.7.html
+ *   TCP_INFO
+ */
+struct TcpStats
+{
+	TcpStats()
+		: bytesReceived(0)
+		, bytesSent(0)
+		, callsRecv(0)
+		, callsSend(0)
+		, recvAgain(0)
+		, sendAgain(0)
+		, sendsPartial(0)
+		, lenSendQueueMax(0)
+		, rttUs(0)
+		, rttVarUs(0)
+		, retransmits(0)
+		, cwnd(0)
+	{}
+
+	void add(const TcpStats &other);
+
+	size_t bytesReceived;
+	size_t bytesSent;
+	uint32_t callsRecv;
+	uint32_t callsSend;
+	uint32_t recvAgain; // EAGAIN
+	uint32_t sendAgain;
+	uint32_t sendsPartial;
+	size_t lenSendQueueMax; // High-water mark
+
+	// TCP_INFO. Linux only
+	uint32_t rttUs;
+	uint32_t rttVarUs;
+	uint32_t retransmits;
+	uint32_t cwnd;
+};
+
+// Pending connect() of a client
+struct ConnAttempt
+{
+	ConnAttempt()
+		: fd(INVALID_SOCKET)
+		, evts()
+	{}
+
+	SOCKET fd;
+	SocketEvents evts;
+};
+
+class TcpSourceTable;
+
+/*
+ * Accepted connection. The address is given by accept().
+ * Peers not handed to TcpTransfering must be closed
+ * with TcpListening::peerClose()
+ */
+struct TcpPeer
+{
+	TcpPeer()
+		: fd(INVALID_SOCKET)
+		, addr()
+		, portLocal(0)
+		, nonBlocking(false)
+		, pSources(NULL)
+	{}
+
+	SOCKET fd;
+	struct sockaddr_storage addr;
+	uint16_t portLocal;
+	bool nonBlocking; // O_NONBLOCK and FD_CLOEXEC set already
+	TcpSourceTable *pSources; // Released when closed
+};
 
 class TcpTransfering : public Transfering
 {
@@ -77,6 +204,11 @@ public:
 		return new (std::nothrow) TcpTransfering(fd);
 	}
 
+	static TcpTransfering *create(const TcpPeer &peer)
+	{
+		return new (std::nothrow) TcpTransfering(peer);
+	}
+
 	static TcpTransfering *create(const std::string &hostAddr, uint16_t hostPort)
 	{
 		return new (std::nothrow) TcpTransfering(hostAddr, hostPort);
@@ -84,7 +216,29 @@ public:
 
 	ssize_t read(void *pBuf, size_t lenReq);
 	ssize_t readFlush();
+	using Transfering::send;
 	ssize_t send(const void *pData, size_t lenReq);
+	ssize_t send(const SendBuf *pBufs, size_t numBufs);
+	size_t sendPending() const;
+	bool sendBlocked() const;
+	void sendQueueLimitsSet(size_t sizeMax, size_t lenHigh, size_t lenLow);
+	Success fileSend(int fd, uint64_t offset, size_t len);
+	Success pipeSend(int fd, size_t len);
+	Success staticSend(const void *pData, size_t len);
+	size_t sendStreamPending() const;
+	void tuningSet(const TcpTuning &tuning);
+	void corkSet(bool corked);
+	void connTimeoutSet(uint32_t tmoMs);
+	void connRetriesSet(uint32_t numRetries,
+						uint32_t backoffMinMs = 100,
+						uint32_t backoffMaxMs = 10000);
+	void fastOpenSet(bool enable);
+	void statsGet(TcpStats &stats);
+	const std::string &addrRemote() const;
+	uint16_t portRemote() const;
+	const std::string &hostAddr() const;
+	uint16_t hostPort() const;
+	static size_t statsListStr(char *pBuf, char *pBufEnd, size_t numConnMax);
 #ifdef _WIN32
 	static bool wsaInit();
 #endif
@@ -92,15 +246,17 @@ public:
 							std::string &strAddr,
 							uint16_t &numPort,
 							bool &isIPv6);
+	static const char *tuningApply(SOCKET fd, const TcpTuning &tuning);
 
 protected:
 
-	virtual ~TcpTransfering() {}
+	virtual ~TcpTransfering();
 
 private:
 
 	TcpTransfering() = delete;
 	TcpTransfering(SOCKET fd);
+	TcpTransfering(const TcpPeer &peer);
 	TcpTransfering(const std::string &hostAddr, uint16_t hostPort);
 	TcpTransfering(const TcpTransfering &) = delete;
 	TcpTransfering &operator=(const TcpTransfering &) = delete;
@@ -114,11 +270,25 @@ private:
 	Success process();
 	Success shutdown();
 
+	bool socketValid();
+	void eventsRegister();
+	ssize_t ringRead(void *pBuf, size_t lenReq);
+	void sendQueueProcess();
+	void sendQueueAppend(const void *pData, size_t len);
+	size_t sendQueueAppend(const SendBuf *pBufs, size_t numBufs, size_t lenSkip, size_t lenMax);
+	ssize_t sendQueueFlush();
+	ssize_t socketSend(const SendBuf *pBufs, size_t numBufs);
+	Success streamStart(int src, int fd, uint64_t offset, const uint8_t *pData, size_t len);
+	ssize_t streamProcess();
+	bool streamSrcReady();
 	void disconnect(int err = 0);
-	Success socketOptionsSet();
+	Success socketOptionsSet(SOCKET fd);
+	Success connAttemptStart();
 	Success connClientDone();
+	void connAttemptsClose();
+	bool connRetryPrepare();
 	void addrInfoSet();
-	struct sockaddr_storage *addrStringToSock(const std::string &strAddr, uint16_t numPort);
+	bool addrStringToSock(const std::string &strAddr, uint16_t numPort, struct sockaddr_storage &addr);
 
 	int errGet();
 	std::string errnoToStr(int num);
@@ -130,30 +300,73 @@ private:
 	std::mutex mSocketFdMtx;
 #endif
 	SOCKET mSocketFd;
+	SocketEvents mEvts;
+	SocketRecv mRecv;
+	uint32_t mEvtsRead; // Zero if data is delivered by the ring
+	struct sockaddr_storage mSockAddrRemote;
+	bool mNonBlocking;
+	TcpSourceTable *mpSources;
 	std::string mHostAddrStr;
 	uint16_t mHostPort;
-	struct sockaddr_storage *mpHostAddr;
+	std::vector<struct sockaddr_storage> mAddrsConn;
+	size_t mIdxAddrConn;
+	std::list<ConnAttempt> mConnAttempts;
+	uint32_t mAttemptMs;
+	uint32_t mTmoConnMs;
+	uint32_t mNumRetriesMax;
+	uint32_t mNumRetries;
+	uint32_t mBackoffMinMs;
+	uint32_t mBackoffMaxMs;
+	uint32_t mDelayRetryMs;
+	bool mFastOpen;
 	int mErrno;
 	bool mInfoSet;
 	bool mIsIPv6Local;
 	bool mIsIPv6Remote;
+	std::atomic<bool> mReadDone; // Set by read() on the caller's thread
+	bool mQuickAckRearm;
+	TcpTuning mTuning;
+
+	// send queue
+	VecByte mBufSend;
+	size_t mIdxBufSend;
+	size_t mSizeSendMax;
+	size_t mLenSendHigh;
+	size_t mLenSendLow;
+	bool mSendBlocked;
+
+	// stream of file, pipe or static data
+	int mSrcStream;
+	int mFdStream;
+	uint64_t mOffStream;
+	const uint8_t *mpStream;
+	size_t mLenStream;
+	bool mStreamSrcWait;
 
 	// statistics
-	size_t mBytesReceived;
-	size_t mBytesSent;
+	TcpStats mStats;
+	bool mIsServer;
 
 	/* static functions */
 	static uint32_t millis();
 	static bool fileNonBlockingSet(SOCKET fd);
+	static void socketClose(SOCKET fd);
 #ifdef _WIN32
 	static void globalWsaDestruct();
+#endif
 
 	/* static variables */
+#ifdef _WIN32
 #if CONFIG_PROC_HAVE_DRIVERS
 	static std::mutex mtxGlobalInit;
 #endif
 	static bool globalInitDone;
 #endif
+	// For statistics
+#if CONFIG_PROC_HAVE_DRIVERS
+	static std::mutex mtxConnections;
+#endif
+	static std::list<TcpTransfering *> connections;
 
 	/* constants */
 
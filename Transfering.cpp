@@ -0,0 +1,242 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "Transfering.h"
+
+using namespace std;
+
+/*
+ * Literature
+ * - https://en.wikipedia.org/wiki/Circular_buffer
+ * - https://man7.org/linux/man-pages/man3/memchr.3.html
+ */
+Success Transfering::exactRead(void *pBuf, size_t lenReq)
+{
+	if (!lenReq)
+		return Positive;
+
+	if (!pBuf)
+		return procErrLog(-1, "buffer not set");
+
+	// Previous frame is released
+	mIdxRecvStart += mLenFrameDone;
+	mLenFrameDone = 0;
+
+	Success success = recvFill(lenReq);
+	if (success != Positive)
+		return success;
+
+	memcpy(pBuf, mBufRecv.data() + mIdxRecvStart, lenReq);
+	mIdxRecvStart += lenReq;
+
+	return Positive;
+}
+
+/*
+ * Return value
+ *   Positive frame valid until the next read
+ *   Pending  frame not complete yet
+ *   < 0      connection closed or invalid data
+ */
+Success Transfering::frameRead(RecvFrame &frame)
+{
+	ssize_t lenFrame;
+	Success success;
+
+	mIdxRecvStart += mLenFrameDone;
+	mLenFrameDone = 0;
+
+	lenFrame = recvDecode(frame);
+	if (lenFrame < 0)
+		return lenFrame;
+
+	if (lenFrame)
+		return Positive;
+
+	success = recvFill(recvPending() + 1);
+	if (success != Positive)
+		return success;
+
+	lenFrame = recvDecode(frame);
+	if (lenFrame < 0)
+		return lenFrame;
+
+	return lenFrame ? Positive : Pending;
+}
+
+// Without decoder every chunk of data is a frame
+void Transfering::frameDecoderSet(FuncFrameDecode pFctDecode, size_t param)
+{
+	mpFctDecode = pFctDecode;
+	mParamDecode = param;
+}
+
+void Transfering::recvSizeMaxSet(size_t sizeMax)
+{
+	mSizeRecvMax = PMAX(sizeMax, mIdxRecvEnd - mIdxRecvStart);
+}
+
+size_t Transfering::recvPending() const
+{
+	return mIdxRecvEnd - mIdxRecvStart - mLenFrameDone;
+}
+
+ssize_t Transfering::frameLineDecode(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param)
+{
+	size_t lenSearch = len;
+
+	if (param)
+		lenSearch = PMIN(len, param + 2);
+
+	const uint8_t *pEnd = (const uint8_t *)memchr(pBuf, '\n', lenSearch);
+	if (!pEnd)
+		return param && len >= param + 2 ? -1 : 0;
+
+	frame.pData = pBuf;
+	frame.len = pEnd - pBuf;
+
+	if (frame.len && pBuf[frame.len - 1] == '\r')
+		--frame.len;
+
+	if (param && frame.len > param)
+		return -1;
+
+	return pEnd - pBuf + 1;
+}
+
+ssize_t Transfering::frameLenPrefixDecode(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param)
+{
+	size_t lenHdr = param ? param : 4;
+	size_t lenPayload = 0;
+
+	if (lenHdr != 1 && lenHdr != 2 && lenHdr != 4)
+		return -1;
+
+	if (len < lenHdr)
+		return 0;
+
+	for (size_t i = 0; i < lenHdr; ++i)
+		lenPayload = lenPayload << 8 | pBuf[i];
+
+	if (len - lenHdr < lenPayload)
+		return 0;
+
+	frame.pData = pBuf + lenHdr;
+	frame.len = lenPayload;
+
+	return lenHdr + lenPayload;
+}
+
+ssize_t Transfering::frameFixedDecode(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param)
+{
+	if (!param)
+		return -1;
+
+	if (len < param)
+		return 0;
+
+	frame.pData = pBuf;
+	frame.len = param;
+
+	return param;
+}
+
+/*
+ * One read per call. The buffer grows in chunks
+ * up to the maximum size and is compacted on demand
+ */
+Success Transfering::recvFill(size_t lenMin)
+{
+	size_t lenPending = mIdxRecvEnd - mIdxRecvStart;
+	size_t sizeBuf;
+	ssize_t lenRead;
+
+	if (lenPending >= lenMin)
+		return Positive;
+
+	if (lenMin > mSizeRecvMax)
+		return procErrLog(-1, "receive buffer too small. Required %zu, max %zu",
+							lenMin, mSizeRecvMax);
+
+	if (mIdxRecvStart)
+	{
+		if (lenPending)
+			memmove(mBufRecv.data(), mBufRecv.data() + mIdxRecvStart, lenPending);
+
+		mIdxRecvStart = 0;
+		mIdxRecvEnd = lenPending;
+	}
+
+	sizeBuf = PMIN(PMAX(lenMin, lenPending + CONFIG_PROC_SIZE_RECV_CHUNK), mSizeRecvMax);
+	if (mBufRecv.size() < sizeBuf)
+		mBufRecv.resize(sizeBuf);
+
+	mRecvFilling = true;
+	lenRead = read(mBufRecv.data() + mIdxRecvEnd, mBufRecv.size() - mIdxRecvEnd);
+	mRecvFilling = false;
+	if (!lenRead)
+		return Pending;
+
+	if (lenRead < 0)
+		return -2;
+
+	mIdxRecvEnd += lenRead;
+
+	return mIdxRecvEnd >= lenMin ? Positive : Pending;
+}
+
+ssize_t Transfering::recvDecode(RecvFrame &frame)
+{
+	const uint8_t *pBuf = mBufRecv.data() + mIdxRecvStart;
+	size_t len = mIdxRecvEnd - mIdxRecvStart;
+	ssize_t lenFrame;
+
+	if (!len)
+		return 0;
+
+	if (!mpFctDecode)
+	{
+		frame.pData = pBuf;
+		frame.len = len;
+		mLenFrameDone = len;
+
+		return len;
+	}
+
+	lenFrame = mpFctDecode(pBuf, len, frame, mParamDecode);
+	if (lenFrame < 0)
+		return procErrLog(-3, "could not decode frame");
+
+	mLenFrameDone = lenFrame;
+
+	return lenFrame;
+}
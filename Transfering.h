@@ -34,6 +34,38 @@
 typedef std::vector<uint8_t> VecByte;
 typedef std::vector<uint8_t>::iterator VecByteIter;
 
+// Scatter/gather
+struct SendBuf
+{
+	const void *pData;
+	size_t len;
+};
+
+#define dSendBufStr(s)		{ s, sizeof(s) - 1 }
+
+#ifndef CONFIG_PROC_SIZE_RECV_CHUNK
+#define CONFIG_PROC_SIZE_RECV_CHUNK		4096
+#endif
+
+#ifndef CONFIG_PROC_SIZE_RECV_MAX
+#define CONFIG_PROC_SIZE_RECV_MAX		(64 * 1024)
+#endif
+
+// Points into the receive buffer. Valid until the next read
+struct RecvFrame
+{
+	const uint8_t *pData;
+	size_t len;
+};
+
+/*
+ * Return value
+ *   > 0 number of bytes consumed incl. header or delimiter
+ *   = 0 frame not complete yet
+ *   < 0 invalid data
+ */
+typedef ssize_t (*FuncFrameDecode)(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param);
+
 class Transfering : public Processing
 {
 
@@ -47,34 +79,93 @@ public:
 	virtual ssize_t send(VecByte &pkt)
 	{ return send(pkt.data(), pkt.size()); }
 
+	// Default: One send per buffer
+	virtual ssize_t send(const SendBuf *pBufs, size_t numBufs)
+	{
+		ssize_t res, lenSum = 0;
+
+		for (; numBufs; --numBufs, ++pBufs)
+		{
+			res = send(pBufs->pData, pBufs->len);
+			if (res < 0)
+				return res;
+
+			lenSum += res;
+		}
+
+		return lenSum;
+	}
+
+	// Backpressure. Number of bytes accepted but not sent yet
+	virtual size_t sendPending() const
+	{ return 0; }
+
+	// Backpressure. Set above the high watermark, cleared below the low watermark
+	virtual bool sendBlocked() const
+	{ return false; }
+
 	/*
+	 * Stream the content of a file, a pipe or static memory
+	 * without copying it into the send queue. The source must
+	 * be kept valid until sendStreamPending() returns zero
+	 *
 	 * Return value
-	 *   > 0 number of bytes read
-	 *   = 0 no data at the moment, but data can be expected in the future
-	 *   < 0 no data can be expected in the future
+	 *   Positive stream started
+	 *   Pending  previous data not sent yet. Try again
+	 *   < 0      not supported or error
 	 */
-	virtual ssize_t read(void *pBuf, size_t lenReq) = 0;
-	Success exactRead(void *pBuf, size_t lenReq)
+	virtual Success fileSend(int fd, uint64_t offset, size_t len)
 	{
-		if (!lenReq)
-			return Positive;
+		(void)fd;
+		(void)offset;
+		(void)len;
+		return procErrLog(-1, "sending files not supported");
+	}
 
-		if (!pBuf)
-			return procErrLog(-1, "buffer not set");
+	virtual Success pipeSend(int fd, size_t len)
+	{
+		(void)fd;
+		(void)len;
+		return procErrLog(-1, "sending pipes not supported");
+	}
 
-		ssize_t lenRead = read(pBuf, lenReq);
+	virtual Success staticSend(const void *pData, size_t len)
+	{
+		ssize_t res = send(pData, len);
+		if (res < 0)
+			return res;
 
-		if (!lenRead)
-			return Pending;
+		return (size_t)res == len ? Positive : Pending;
+	}
 
-		if (lenRead < 0)
-			return -2;
+	virtual size_t sendStreamPending() const
+	{ return 0; }
 
-		if ((size_t)lenRead != lenReq)
-			return procErrLog(-3, "read data len does not match. Requested %d, got %d", lenReq, lenRead);
+	/*
+	 * Return value
+	 *   > 0 number of bytes read
+	 *   = 0 no data at the moment, but data can be expected in the future
+	 *   < 0 no data can be expected in the future
+	 */
+	virtual ssize_t read(void *pBuf, size_t lenReq) = 0;
 
-		return Positive;
-	}
+	/*
+	 * Buffered receive. Data is read in large chunks with one
+	 * syscall and handed out in frames without extra copies.
+	 * Don't mix with read(). It fails while data is buffered
+	 */
+	Success exactRead(void *pBuf, size_t lenReq);
+	Success frameRead(RecvFrame &frame);
+	void frameDecoderSet(FuncFrameDecode pFctDecode, size_t param = 0);
+	void recvSizeMaxSet(size_t sizeMax);
+	size_t recvPending() const;
+
+	// param: Maximum line length. Frame without "\r\n"
+	static ssize_t frameLineDecode(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param);
+	// param: Size of the big endian length header. 1, 2 or 4 (default)
+	static ssize_t frameLenPrefixDecode(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param);
+	// param: Frame size
+	static ssize_t frameFixedDecode(const uint8_t *pBuf, size_t len, RecvFrame &frame, size_t param);
 
 	void doneSet()
 	{
@@ -89,6 +180,11 @@ public:
 		return mAddrRemote;
 	}
 
+	virtual uint16_t portRemote() const
+	{
+		return mPortRemote;
+	}
+
 protected:
 
 	Transfering(const char *name)
@@ -100,6 +196,13 @@ protected:
 		, mAddrRemote("")
 		, mPortRemote(0)
 		, mDone(false)
+		, mIdxRecvStart(0)
+		, mIdxRecvEnd(0)
+		, mLenFrameDone(0)
+		, mSizeRecvMax(CONFIG_PROC_SIZE_RECV_MAX)
+		, mpFctDecode(NULL)
+		, mParamDecode(0)
+		, mRecvFilling(false)
 	{}
 	virtual ~Transfering() {}
 
@@ -110,6 +213,12 @@ protected:
 
 	bool mDone;
 
+	// Data buffered by the frame API would be skipped
+	bool readMixed(const void *pBuf, size_t lenReq) const
+	{
+		return pBuf && lenReq && !mRecvFilling && recvPending();
+	}
+
 private:
 
 	Transfering() = delete;
@@ -122,8 +231,18 @@ private:
 	 */
 
 	/* member functions */
+	Success recvFill(size_t lenMin);
+	ssize_t recvDecode(RecvFrame &frame);
 
 	/* member variables */
+	VecByte mBufRecv;
+	size_t mIdxRecvStart;
+	size_t mIdxRecvEnd;
+	size_t mLenFrameDone;
+	size_t mSizeRecvMax;
+	FuncFrameDecode mpFctDecode;
+	size_t mParamDecode;
+	bool mRecvFilling;
 
 	/* static functions */
 
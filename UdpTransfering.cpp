@@ -0,0 +1,788 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "UdpTransfering.h"
+
+#if CONFIG_PROC_HAVE_UDP
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#if defined(__linux__)
+#include <netinet/udp.h>
+#endif
+
+#define dForEach_ProcState(gen) \
+		gen(StStart) \
+		gen(StMain) \
+		gen(StTmp) \
+
+#define dGenProcStateEnum(s) s,
+dProcessStateEnum(ProcState);
+
+#if 0
+#define dGenProcStateString(s) #s,
+dProcessStateStr(ProcState);
+#endif
+
+using namespace std;
+
+#ifndef SOL_UDP
+#define SOL_UDP IPPROTO_UDP
+#endif
+
+#if CONFIG_PROC_HAVE_MMSG
+typedef struct mmsghdr UdpMsgHdr;
+#else
+struct UdpMsgHdr
+{
+	struct msghdr msg_hdr;
+	unsigned int msg_len;
+};
+#endif
+
+// Batches per tick and direction. Keeps other processes responsive
+#define dNumBatchesPerTick			4
+
+// Limits of UDP_SEGMENT
+#define dNumSegmentsGsoMax			64
+#define dSizeGsoMax				65507
+
+// Receive slot with GRO enabled
+#define dSizeGroMax				65535
+
+UdpTransfering::UdpTransfering()
+	: Processing("UdpTransfering")
+	, ppPktRecv()
+	, ppPktSend()
+	, ppPktFree()
+	, mPortLocal(0)
+	, mAddrLocal()
+	, mAddrRemote()
+	, mSockAddrRemote()
+	, mNumMsgsBatch(CONFIG_PROC_UDP_NUM_MSGS_BATCH)
+	, mSizeDatagramMax(CONFIG_PROC_UDP_SIZE_DATAGRAM_MAX)
+	, mOffload(false)
+	, mOffloadActive(false)
+	, mSocketFd(-1)
+	, mEvts()
+	, mBufRecv()
+	, mAddrsRecv()
+	, mVecsRecv()
+	, mCtrlRecv()
+	, mSizeSlotRecv(0)
+	, mNumMsgsRecv(0)
+	, mRecvBlocked(false)
+	, mPktsSend()
+	, mIdxPktsSend(0)
+	, mSendBlocked(false)
+	, mPktsReceived(0)
+	, mPktsSent(0)
+	, mBytesReceived(0)
+	, mBytesSent(0)
+	, mCallsRecv(0)
+	, mCallsSend(0)
+	, mPktsTruncated(0)
+	, mPktsDropped(0)
+	, mPktsRecycled(0)
+{
+	mState = StStart;
+}
+
+/* input */
+
+// Unset address: Any. Dual stack
+void UdpTransfering::bindSet(uint16_t port, const string &addrLocal)
+{
+	mPortLocal = port;
+	mAddrLocal = addrLocal;
+}
+
+// Default destination. Numeric addresses only
+void UdpTransfering::remoteSet(const string &addrRemote, uint16_t port)
+{
+	mAddrRemote = addrRemote;
+
+	if (!addrStringToSock(addrRemote, port, mSockAddrRemote))
+		memset(&mSockAddrRemote, 0, sizeof(mSockAddrRemote));
+}
+
+void UdpTransfering::batchSizeSet(size_t numMsgs)
+{
+	if (!numMsgs)
+		numMsgs = 1;
+
+	if (numMsgs > CONFIG_PROC_UDP_NUM_MSGS_BATCH)
+		numMsgs = CONFIG_PROC_UDP_NUM_MSGS_BATCH;
+
+	mNumMsgsBatch = numMsgs;
+}
+
+void UdpTransfering::sizeDatagramMaxSet(size_t size)
+{
+	if (!size)
+		size = CONFIG_PROC_UDP_SIZE_DATAGRAM_MAX;
+
+	if (size > dSizeGroMax)
+		size = dSizeGroMax;
+
+	mSizeDatagramMax = size;
+}
+
+// GSO and GRO. Linux only
+void UdpTransfering::offloadSet(bool enable)
+{
+	mOffload = enable;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/udp.7.html
+ * - https://man7.org/linux/man-pages/man2/recvmmsg.2.html
+ * - https://man7.org/linux/man-pages/man2/sendmmsg.2.html
+ */
+Success UdpTransfering::process()
+{
+	Success success;
+	ssize_t res;
+	size_t i;
+#if 0
+	dStateTrace;
+#endif
+	switch (mState)
+	{
+	case StStart:
+
+		success = socketCreate();
+		if (success != Positive)
+			return procErrLog(-1, "could not create socket");
+
+		buffersAlloc();
+
+		if (!sockEvtsRegister(mEvts, mSocketFd))
+			procDbgLog("socket events not available. Polling socket");
+
+		mState = StMain;
+
+		break;
+	case StMain:
+
+		// Sizes changed after start
+		if (mNumMsgsRecv != mNumMsgsBatch ||
+				(!mOffloadActive && mSizeSlotRecv != mSizeDatagramMax))
+			buffersAlloc();
+
+		for (i = 0; i < dNumBatchesPerTick; ++i)
+		{
+			res = batchReceive();
+			if (res < 0)
+				return procErrLog(-1, "could not receive datagrams");
+
+			if ((size_t)res < mNumMsgsRecv)
+				break;
+		}
+
+		for (i = 0; i < dNumBatchesPerTick; ++i)
+		{
+			res = batchSend();
+			if (res <= 0)
+				break;
+		}
+
+		break;
+	case StTmp:
+
+		break;
+	default:
+		break;
+	}
+
+	return Pending;
+}
+
+Success UdpTransfering::shutdown()
+{
+	sockEvtsUnregister(mEvts);
+
+	if (mSocketFd >= 0)
+	{
+		::close(mSocketFd);
+		mSocketFd = -1;
+	}
+
+	ppPktRecv.sourceDoneSet();
+
+	return Positive;
+}
+
+Success UdpTransfering::socketCreate()
+{
+	struct sockaddr_storage addr;
+	socklen_t lenAddr;
+	bool bindReq = mPortLocal || mAddrLocal.size();
+	bool ok;
+	int opt, res;
+
+	memset(&addr, 0, sizeof(addr));
+
+	if (mAddrLocal.size())
+	{
+		ok = addrStringToSock(mAddrLocal, mPortLocal, addr);
+		if (!ok)
+			return procErrLog(-1, "invalid local address: %s", mAddrLocal.c_str());
+	}
+	else
+	if (!bindReq && mSockAddrRemote.ss_family)
+		addr.ss_family = mSockAddrRemote.ss_family;
+	else
+	{
+		struct sockaddr_in6 *pAddr6 = (struct sockaddr_in6 *)&addr;
+
+		pAddr6->sin6_family = AF_INET6;
+		pAddr6->sin6_addr = in6addr_any;
+		pAddr6->sin6_port = htons(mPortLocal);
+	}
+
+	if (mAddrRemote.size() && !mSockAddrRemote.ss_family)
+		return procErrLog(-1, "invalid remote address: %s", mAddrRemote.c_str());
+
+	mSocketFd = ::socket(addr.ss_family, SOCK_DGRAM, 0);
+	if (mSocketFd < 0)
+		return procErrLog(-1, "could not create socket: %s",
+							errnoToStr(errno).c_str());
+
+	ok = fileNonBlockingSet(mSocketFd);
+	if (!ok)
+		return procErrLog(-1, "could not set non blocking mode: %s",
+							errnoToStr(errno).c_str());
+
+	if (addr.ss_family == AF_INET6 && !mAddrLocal.size())
+	{
+		// Also accept IPv4 mapped addresses
+		opt = 0;
+		::setsockopt(mSocketFd, IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof(opt));
+	}
+
+	if (bindReq)
+	{
+		lenAddr = addr.ss_family == AF_INET6 ?
+					sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+
+		res = ::bind(mSocketFd, (struct sockaddr *)&addr, lenAddr);
+		if (res)
+			return procErrLog(-1, "could not bind to port %u: %s",
+							mPortLocal, errnoToStr(errno).c_str());
+	}
+#if defined(UDP_GRO) && defined(UDP_SEGMENT)
+	if (mOffload)
+	{
+		// Kernels with GRO also support GSO
+		opt = 1;
+		res = ::setsockopt(mSocketFd, SOL_UDP, UDP_GRO, &opt, sizeof(opt));
+		if (res)
+			procWrnLog("segmentation offload not available: %s",
+							errnoToStr(errno).c_str());
+
+		mOffloadActive = !res;
+	}
+#else
+	if (mOffload)
+		procWrnLog("segmentation offload not supported");
+#endif
+	return Positive;
+}
+
+void UdpTransfering::buffersAlloc()
+{
+	size_t i;
+
+	mSizeSlotRecv = mOffloadActive ? dSizeGroMax : mSizeDatagramMax;
+	mNumMsgsRecv = mNumMsgsBatch;
+
+	mBufRecv.resize(mNumMsgsRecv * mSizeSlotRecv);
+	mAddrsRecv.resize(mNumMsgsRecv);
+	mVecsRecv.resize(mNumMsgsRecv);
+	mCtrlRecv.resize(mNumMsgsRecv * CMSG_SPACE(sizeof(int)));
+
+	for (i = 0; i < mNumMsgsRecv; ++i)
+	{
+		mVecsRecv[i].iov_base = mBufRecv.data() + i * mSizeSlotRecv;
+		mVecsRecv[i].iov_len = mSizeSlotRecv;
+	}
+
+	mPktsSend.reserve(mNumMsgsBatch);
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/recvmmsg.2.html
+ * - https://lwn.net/Articles/768995/
+ *   UDP GRO
+ *
+ * Return value: Number of datagrams received
+ */
+ssize_t UdpTransfering::batchReceive()
+{
+	UdpMsgHdr msgs[CONFIG_PROC_UDP_NUM_MSGS_BATCH];
+	PipeEntry<UdpPacket> entryFree;
+	size_t numMsgs = mNumMsgsRecv;
+	size_t numFree;
+	struct cmsghdr *pCmsg;
+	struct msghdr *pHdr;
+	ssize_t res;
+	size_t i, len;
+	int sizeSeg;
+
+	if (ppPktRecv.size() >= ppPktRecv.sizeMax())
+	{
+		// Data stays in the socket buffer. Level-triggered
+		// read events would wake the driver all the time
+		if (!mRecvBlocked)
+		{
+			mRecvBlocked = true;
+			eventsInterestUpdate();
+		}
+
+		return 0;
+	}
+
+	if (mRecvBlocked)
+	{
+		mRecvBlocked = false;
+		eventsInterestUpdate();
+	}
+
+	if (sockEvtsRegistered(mEvts) &&
+			!(sockEvtsGet(mEvts) & (SockEvtRead | SockEvtErr)))
+		return 0;
+
+	numFree = ppPktRecv.sizeMax() - ppPktRecv.size();
+	if (numMsgs > numFree)
+		numMsgs = numFree;
+
+	memset(msgs, 0, numMsgs * sizeof(*msgs));
+
+	for (i = 0; i < numMsgs; ++i)
+	{
+		pHdr = &msgs[i].msg_hdr;
+
+		pHdr->msg_name = &mAddrsRecv[i];
+		pHdr->msg_namelen = sizeof(mAddrsRecv[i]);
+		pHdr->msg_iov = &mVecsRecv[i];
+		pHdr->msg_iovlen = 1;
+
+		if (!mOffloadActive)
+			continue;
+
+		pHdr->msg_control = mCtrlRecv.data() + i * CMSG_SPACE(sizeof(int));
+		pHdr->msg_controllen = CMSG_SPACE(sizeof(int));
+	}
+#if CONFIG_PROC_HAVE_MMSG
+	res = ::recvmmsg(mSocketFd, msgs, numMsgs, 0, NULL);
+#else
+	for (res = 0; (size_t)res < numMsgs; ++res)
+	{
+		ssize_t numBytes = ::recvmsg(mSocketFd, &msgs[res].msg_hdr, 0);
+		if (numBytes < 0)
+			break;
+
+		msgs[res].msg_len = numBytes;
+	}
+
+	if (!res)
+		res = -1;
+#endif
+	++mCallsRecv;
+
+	if (res < 0)
+	{
+		int numErr = errno;
+
+		if (numErr == EWOULDBLOCK || numErr == EAGAIN)
+		{
+			sockEvtsClear(mEvts, SockEvtRead);
+			return 0; // std case and ok
+		}
+
+		// Pending ICMP errors of previous datagrams
+		if (numErr == ECONNREFUSED || numErr == EHOSTUNREACH ||
+				numErr == ENETUNREACH)
+		{
+			procDbgLog("datagram error: %s", errnoToStr(numErr).c_str());
+			return 0;
+		}
+
+		return procErrLog(-1, "recvmmsg() failed: %s",
+							errnoToStr(numErr).c_str());
+	}
+
+	if ((size_t)res < numMsgs)
+		sockEvtsClear(mEvts, SockEvtRead);
+
+	for (i = 0; i < (size_t)res; ++i)
+	{
+		pHdr = &msgs[i].msg_hdr;
+		len = msgs[i].msg_len;
+
+		if (pHdr->msg_flags & MSG_TRUNC)
+		{
+			++mPktsTruncated;
+			continue;
+		}
+
+		UdpPacket pkt;
+
+		// Keeps the allocated data buffer
+		if (ppPktFree.get(entryFree) > 0)
+		{
+			pkt = std::move(entryFree.particle);
+			pkt.sizeSeg = 0;
+			++mPktsRecycled;
+		}
+
+		memcpy(&pkt.addr, &mAddrsRecv[i], sizeof(pkt.addr));
+		pkt.data.assign((uint8_t *)mVecsRecv[i].iov_base,
+						(uint8_t *)mVecsRecv[i].iov_base + len);
+#if defined(UDP_GRO)
+		for (pCmsg = CMSG_FIRSTHDR(pHdr); pCmsg; pCmsg = CMSG_NXTHDR(pHdr, pCmsg))
+		{
+			if (pCmsg->cmsg_level != SOL_UDP || pCmsg->cmsg_type != UDP_GRO)
+				continue;
+
+			memcpy(&sizeSeg, CMSG_DATA(pCmsg), sizeof(sizeSeg));
+
+			if (sizeSeg > 0 && (size_t)sizeSeg < len)
+				pkt.sizeSeg = sizeSeg;
+		}
+#else
+		(void)pCmsg;
+		(void)sizeSeg;
+#endif
+		ppPktRecv.commit(std::move(pkt), nowMs());
+
+		++mPktsReceived;
+		mBytesReceived += len;
+	}
+
+	return res;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/sendmmsg.2.html
+ * - https://lwn.net/Articles/752184/
+ *   UDP GSO
+ *
+ * Return value: Number of datagrams sent
+ */
+ssize_t UdpTransfering::batchSend()
+{
+	UdpMsgHdr msgs[CONFIG_PROC_UDP_NUM_MSGS_BATCH];
+	union
+	{
+		char buf[CMSG_SPACE(sizeof(uint16_t))];
+		struct cmsghdr align;
+	} ctrl[CONFIG_PROC_UDP_NUM_MSGS_BATCH];
+	struct iovec vecs[CONFIG_PROC_UDP_NUM_MSGS_BATCH];
+	PipeEntry<UdpPacket> entry;
+	struct cmsghdr *pCmsg;
+	struct msghdr *pHdr;
+	size_t numMsgs, i;
+	UdpPacket *pPkt;
+	ssize_t res;
+
+	if (mIdxPktsSend == mPktsSend.size())
+	{
+		mPktsSend.clear();
+		mIdxPktsSend = 0;
+	}
+
+	while (mPktsSend.size() < mNumMsgsBatch && ppPktSend.get(entry) > 0)
+		packetStage(entry.particle);
+
+	numMsgs = mPktsSend.size() - mIdxPktsSend;
+	if (!numMsgs)
+		return 0;
+
+	if (numMsgs > mNumMsgsBatch)
+		numMsgs = mNumMsgsBatch;
+
+	if (mSendBlocked && sockEvtsRegistered(mEvts) &&
+			!(sockEvtsGet(mEvts) & (SockEvtWrite | SockEvtErr)))
+		return 0;
+
+	memset(msgs, 0, numMsgs * sizeof(*msgs));
+
+	for (i = 0; i < numMsgs; ++i)
+	{
+		pPkt = &mPktsSend[mIdxPktsSend + i];
+		pHdr = &msgs[i].msg_hdr;
+
+		vecs[i].iov_base = pPkt->data.data();
+		vecs[i].iov_len = pPkt->data.size();
+
+		pHdr->msg_name = &pPkt->addr;
+		pHdr->msg_namelen = pPkt->addr.ss_family == AF_INET6 ?
+					sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+		pHdr->msg_iov = &vecs[i];
+		pHdr->msg_iovlen = 1;
+
+		if (!pPkt->sizeSeg)
+			continue;
+#if defined(UDP_SEGMENT)
+		memset(&ctrl[i], 0, sizeof(ctrl[i]));
+
+		pHdr->msg_control = ctrl[i].buf;
+		pHdr->msg_controllen = sizeof(ctrl[i].buf);
+
+		pCmsg = CMSG_FIRSTHDR(pHdr);
+		pCmsg->cmsg_level = SOL_UDP;
+		pCmsg->cmsg_type = UDP_SEGMENT;
+		pCmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		memcpy(CMSG_DATA(pCmsg), &pPkt->sizeSeg, sizeof(uint16_t));
+#else
+		(void)ctrl;
+		(void)pCmsg;
+#endif
+	}
+#if CONFIG_PROC_HAVE_MMSG
+	res = ::sendmmsg(mSocketFd, msgs, numMsgs, 0);
+#else
+	for (res = 0; (size_t)res < numMsgs; ++res)
+	{
+		if (::sendmsg(mSocketFd, &msgs[res].msg_hdr, 0) < 0)
+			break;
+	}
+
+	if (!res)
+		res = -1;
+#endif
+	++mCallsSend;
+
+	if (res < 0)
+	{
+		int numErr = errno;
+
+		if (numErr == EWOULDBLOCK || numErr == EAGAIN || numErr == ENOBUFS)
+		{
+			mSendBlocked = true;
+			eventsInterestUpdate();
+			sockEvtsClear(mEvts, SockEvtWrite);
+			return 0;
+		}
+
+		// Errors belong to the first datagram. Drop it
+		procDbgLog("could not send datagram: %s", errnoToStr(numErr).c_str());
+
+		++mIdxPktsSend;
+		++mPktsDropped;
+
+		return 0;
+	}
+
+	for (i = 0; i < (size_t)res; ++i)
+		mBytesSent += mPktsSend[mIdxPktsSend + i].data.size();
+
+	mIdxPktsSend += res;
+	mPktsSent += res;
+
+	if (mSendBlocked)
+	{
+		mSendBlocked = false;
+		eventsInterestUpdate();
+	}
+
+	return res;
+}
+
+void UdpTransfering::eventsInterestUpdate()
+{
+	uint32_t interest = 0;
+
+	if (!mRecvBlocked)
+		interest |= SockEvtRead;
+
+	if (mSendBlocked)
+		interest |= SockEvtWrite;
+
+	sockEvtsInterestSet(mEvts, interest);
+}
+
+/*
+ * Sets the default destination and splits segmented
+ * packets the kernel can't handle
+ */
+void UdpTransfering::packetStage(UdpPacket &pkt)
+{
+	size_t len = pkt.data.size();
+	size_t sizeSeg = pkt.sizeSeg;
+	size_t idx;
+
+	if (!pkt.addr.ss_family)
+		memcpy(&pkt.addr, &mSockAddrRemote, sizeof(pkt.addr));
+
+	if (!pkt.addr.ss_family)
+	{
+		procDbgLog("no destination for datagram");
+		++mPktsDropped;
+		return;
+	}
+
+	if (sizeSeg >= len)
+		pkt.sizeSeg = 0;
+
+	if (!pkt.sizeSeg)
+	{
+		mPktsSend.push_back(std::move(pkt));
+		return;
+	}
+
+	if (mOffloadActive && len <= dSizeGsoMax &&
+			(len + sizeSeg - 1) / sizeSeg <= dNumSegmentsGsoMax)
+	{
+		mPktsSend.push_back(std::move(pkt));
+		return;
+	}
+
+	for (idx = 0; idx < len; idx += sizeSeg)
+	{
+		UdpPacket seg;
+
+		memcpy(&seg.addr, &pkt.addr, sizeof(seg.addr));
+		seg.data.assign(pkt.data.begin() + idx,
+						pkt.data.begin() + (idx + sizeSeg < len ? idx + sizeSeg : len));
+
+		mPktsSend.push_back(std::move(seg));
+	}
+}
+
+void UdpTransfering::processInfo(char *pBuf, char *pBufEnd)
+{
+	//dInfo("State\t\t\t%s\n", ProcStateString[mState]);
+	dInfo("Datagrams received\t%zu (%zu calls)\n", mPktsReceived, mCallsRecv);
+	dInfo("Datagrams recycled\t%zu\n", mPktsRecycled);
+	dInfo("Datagrams sent\t\t%zu (%zu calls)\n", mPktsSent, mCallsSend);
+	dInfo("Bytes\t\t\t%zu received, %zu sent\n", mBytesReceived, mBytesSent);
+
+	if (mPktsTruncated || mPktsDropped)
+		dInfo("Datagrams lost\t\t%u truncated, %u dropped\n",
+						mPktsTruncated, mPktsDropped);
+
+	dInfo("Batch\t\t\t%zu%s\n", mNumMsgsBatch, mOffloadActive ? " (offload)" : "");
+
+	if (mPortLocal)
+		dInfo("Port\t\t\t%u\n", mPortLocal);
+
+	if (mAddrRemote.size())
+		dInfo("Remote\t\t\t%s\n", mAddrRemote.c_str());
+}
+
+/* static functions */
+
+bool UdpTransfering::addrStringToSock(const string &strAddr,
+							uint16_t numPort,
+							struct sockaddr_storage &addr)
+{
+	struct sockaddr_in *pAddr4 = (struct sockaddr_in *)&addr;
+	struct sockaddr_in6 *pAddr6 = (struct sockaddr_in6 *)&addr;
+
+	memset(&addr, 0, sizeof(addr));
+
+	if (inet_pton(AF_INET, strAddr.c_str(), &pAddr4->sin_addr) == 1)
+	{
+		pAddr4->sin_family = AF_INET;
+		pAddr4->sin_port = htons(numPort);
+	}
+	else
+	if (inet_pton(AF_INET6, strAddr.c_str(), &pAddr6->sin6_addr) == 1)
+	{
+		pAddr6->sin6_family = AF_INET6;
+		pAddr6->sin6_port = htons(numPort);
+	}
+	else
+		return false;
+
+	return true;
+}
+
+bool UdpTransfering::fileNonBlockingSet(int fd)
+{
+	int opt;
+
+	opt = fcntl(fd, F_GETFL, 0);
+	if (opt == -1)
+		return false;
+
+	opt |= O_NONBLOCK;
+
+	opt = fcntl(fd, F_SETFL, opt);
+	if (opt == -1)
+		return false;
+
+	opt = fcntl(fd, F_GETFD, 0);
+	if (opt == -1)
+		return false;
+
+	// Don't leak into child processes
+	opt |= FD_CLOEXEC;
+
+	opt = fcntl(fd, F_SETFD, opt);
+	if (opt == -1)
+		return false;
+
+	return true;
+}
+
+string UdpTransfering::errnoToStr(int num)
+{
+	char buf[64];
+	size_t len = sizeof(buf) - 1;
+	char *pBuf;
+
+	buf[0] = 0;
+	buf[len] = 0;
+
+#if defined(__FreeBSD__) || defined(__APPLE__)
+	int res;
+
+	pBuf = buf;
+	res = ::strerror_r(num, buf, len);
+	if (res)
+		*pBuf = 0;
+#else
+	pBuf = ::strerror_r(num, buf, len);
+#endif
+	return string(pBuf);
+}
+
+#endif
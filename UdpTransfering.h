@@ -0,0 +1,201 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef UDP_TRANSFERING_H
+#define UDP_TRANSFERING_H
+
+#include <string>
+#include <vector>
+
+#include "Processing.h"
+#include "Pipe.h"
+#include "Transfering.h"
+#include "SocketEvents.h"
+
+#ifndef CONFIG_PROC_HAVE_UDP
+#if defined(__unix__) || defined(__APPLE__)
+#define CONFIG_PROC_HAVE_UDP				1
+#else
+#define CONFIG_PROC_HAVE_UDP				0
+#endif
+#endif
+
+// recvmmsg() and sendmmsg(). Otherwise one syscall per datagram
+#ifndef CONFIG_PROC_HAVE_MMSG
+#if defined(__linux__)
+#define CONFIG_PROC_HAVE_MMSG				1
+#else
+#define CONFIG_PROC_HAVE_MMSG				0
+#endif
+#endif
+
+// Datagrams per syscall
+#ifndef CONFIG_PROC_UDP_NUM_MSGS_BATCH
+#define CONFIG_PROC_UDP_NUM_MSGS_BATCH		32
+#endif
+
+#ifndef CONFIG_PROC_UDP_SIZE_DATAGRAM_MAX
+#define CONFIG_PROC_UDP_SIZE_DATAGRAM_MAX	2048
+#endif
+
+#if CONFIG_PROC_HAVE_UDP
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/*
+ * If sizeSeg is set, data holds consecutive datagrams
+ * of this size. The last one may be shorter.
+ * Received packets only use it when offloading is enabled
+ */
+struct UdpPacket
+{
+	UdpPacket()
+		: addr()
+		, sizeSeg(0)
+		, data()
+	{}
+
+	struct sockaddr_storage addr; // Remote. Unset: Default destination
+	uint16_t sizeSeg;
+	VecByte data;
+};
+
+/*
+ * Datagrams are exchanged via pipes
+ * - Received:  ppPktRecv.get()
+ * - To send:   ppPktSend.commit()
+ * - Used:      ppPktFree.commit(). Optional. Received
+ *              datagrams are stored in these packets again
+ * The receive buffers are allocated at start and again
+ * when the batch or datagram size changes
+ */
+class UdpTransfering : public Processing
+{
+
+public:
+
+	static UdpTransfering *create()
+	{
+		return new (std::nothrow) UdpTransfering;
+	}
+
+	void bindSet(uint16_t port, const std::string &addrLocal = "");
+	void remoteSet(const std::string &addrRemote, uint16_t port);
+	void batchSizeSet(size_t numMsgs);
+	void sizeDatagramMaxSet(size_t size);
+	void offloadSet(bool enable);
+
+	Pipe<UdpPacket> ppPktRecv;
+	Pipe<UdpPacket> ppPktSend;
+	Pipe<UdpPacket> ppPktFree;
+
+	static bool addrStringToSock(const std::string &strAddr,
+							uint16_t numPort,
+							struct sockaddr_storage &addr);
+
+protected:
+
+	virtual ~UdpTransfering() {}
+
+private:
+
+	UdpTransfering();
+	UdpTransfering(const UdpTransfering &) = delete;
+	UdpTransfering &operator=(const UdpTransfering &) = delete;
+
+	/*
+	 * Naming of functions:  objectVerb()
+	 * Example:              peerAdd()
+	 */
+
+	/* member functions */
+	Success process();
+	Success shutdown();
+
+	Success socketCreate();
+	void buffersAlloc();
+	ssize_t batchReceive();
+	ssize_t batchSend();
+	void eventsInterestUpdate();
+	void packetStage(UdpPacket &pkt);
+	void processInfo(char *pBuf, char *pBufEnd);
+
+	/* member variables */
+	uint16_t mPortLocal;
+	std::string mAddrLocal;
+	std::string mAddrRemote;
+	struct sockaddr_storage mSockAddrRemote;
+	size_t mNumMsgsBatch;
+	size_t mSizeDatagramMax;
+	bool mOffload;
+	bool mOffloadActive;
+
+	int mSocketFd;
+	SocketEvents mEvts;
+
+	// Preallocated receive batch
+	VecByte mBufRecv;
+	std::vector<struct sockaddr_storage> mAddrsRecv;
+	std::vector<struct iovec> mVecsRecv;
+	VecByte mCtrlRecv;
+	size_t mSizeSlotRecv;
+	size_t mNumMsgsRecv;
+	bool mRecvBlocked; // ppPktRecv full
+
+	// Packets taken from ppPktSend but not sent yet
+	std::vector<UdpPacket> mPktsSend;
+	size_t mIdxPktsSend;
+	bool mSendBlocked;
+
+	// statistics
+	size_t mPktsReceived;
+	size_t mPktsSent;
+	size_t mBytesReceived;
+	size_t mBytesSent;
+	size_t mCallsRecv;
+	size_t mCallsSend;
+	uint32_t mPktsTruncated;
+	uint32_t mPktsDropped;
+	size_t mPktsRecycled;
+
+	/* static functions */
+	static bool fileNonBlockingSet(int fd);
+	static std::string errnoToStr(int num);
+
+	/* static variables */
+
+	/* constants */
+
+};
+
+#endif
+
+#endif
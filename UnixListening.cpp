@@ -0,0 +1,314 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "UnixListening.h"
+
+#if CONFIG_PROC_HAVE_UNIX_SOCKETS
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#define dForEach_ProcState(gen) \
+		gen(StStart) \
+		gen(StMain) \
+		gen(StTmp) \
+
+#define dGenProcStateEnum(s) s,
+dProcessStateEnum(ProcState);
+
+#if 0
+#define dGenProcStateString(s) #s,
+dProcessStateStr(ProcState);
+#endif
+
+using namespace std;
+
+#define dCntSkipMax 30
+
+UnixListening::UnixListening()
+	: Processing("UnixListening")
+	, mPath()
+	, mMaxConn(200)
+	, mPathBound(false)
+	, mCntSkip(0)
+	, mFdLst(-1)
+	, mEvts()
+	, mConnCreated(0)
+{
+	mState = StStart;
+}
+
+// Paths starting with '@' use the abstract namespace on Linux
+void UnixListening::pathSet(const string &path)
+{
+	mPath = path;
+}
+
+void UnixListening::maxConnSet(size_t maxConn)
+{
+	mMaxConn = maxConn;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/unix.7.html
+ * - https://man7.org/linux/man-pages/man2/accept.2.html
+ */
+Success UnixListening::process()
+{
+	Success success;
+#if 0
+	dStateTrace;
+#endif
+	switch (mState)
+	{
+	case StStart:
+
+		if (!mPath.size())
+			return procErrLog(-1, "path not set");
+
+		success = socketCreate();
+		if (success != Positive)
+			return procErrLog(-1, "could not create socket");
+
+		sockEvtsRegister(mEvts, mFdLst);
+
+		mState = StMain;
+
+		break;
+	case StMain:
+
+		// Without socket events we poll the socket
+		if (!sockEvtsRegistered(mEvts))
+		{
+			++mCntSkip;
+			if (mCntSkip < dCntSkipMax)
+				return Pending;
+			mCntSkip = 0;
+		}
+
+		success = connectionsAcceptAll();
+		if (success != Pending)
+			return success;
+
+		break;
+	case StTmp:
+
+		break;
+	default:
+		break;
+	}
+
+	return Pending;
+}
+
+Success UnixListening::shutdown()
+{
+	PipeEntry<int> peerFd;
+
+	while (ppPeerFd.get(peerFd) > 0)
+		socketClose(peerFd.particle);
+
+	sockEvtsUnregister(mEvts);
+	socketClose(mFdLst);
+
+	if (mPathBound)
+		::unlink(mPath.c_str());
+	mPathBound = false;
+
+	return Positive;
+}
+
+Success UnixListening::socketCreate()
+{
+	struct sockaddr_un addr;
+	socklen_t lenAddr;
+	int opt;
+	bool ok;
+
+	ok = UnixTransfering::sockaddrUnixSet(mPath, addr, lenAddr);
+	if (!ok)
+		return procErrLog(-1, "invalid socket path. Given: '%s'", mPath.c_str());
+
+	// IMPORTANT
+	// No need to close socket in case of error
+	// This is done in function shutdown()
+
+	mFdLst = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (mFdLst < 0)
+		return procErrLog(-1, "socket() failed: %s", strerror(errno));
+
+	opt = fcntl(mFdLst, F_GETFL, 0);
+	if (opt == -1 || fcntl(mFdLst, F_SETFL, opt | O_NONBLOCK) == -1)
+		return procErrLog(-1, "could not set non blocking mode: %s", strerror(errno));
+
+	// Don't leak into child processes
+	opt = fcntl(mFdLst, F_GETFD, 0);
+	if (opt == -1 || fcntl(mFdLst, F_SETFD, opt | FD_CLOEXEC) == -1)
+		return procErrLog(-1, "could not set close on exec: %s", strerror(errno));
+
+	// Stale socket file of a previous run. Never
+	// take the path from a server still running
+	if (addr.sun_path[0])
+	{
+		if (socketPathFree(addr, lenAddr) != Positive)
+			return procErrLog(-1, "socket path %s in use", mPath.c_str());
+
+		::unlink(addr.sun_path);
+	}
+
+	if (::bind(mFdLst, (struct sockaddr *)&addr, lenAddr) < 0)
+		return procErrLog(-1, "bind(%s) failed: %s", mPath.c_str(), strerror(errno));
+
+	mPathBound = addr.sun_path[0];
+
+	if (::listen(mFdLst, 8192) < 0)
+		return procErrLog(-1, "listen() failed: %s", strerror(errno));
+
+	return Positive;
+}
+
+Success UnixListening::connectionsAcceptAll()
+{
+	Success success;
+
+	if (sockEvtsRegistered(mEvts) && !(sockEvtsGet(mEvts) & SockEvtRead))
+		return Pending;
+
+	while (1)
+	{
+		success = connectionsAccept();
+		if (success != Positive)
+			break;
+	}
+
+	if (success == Pending)
+		sockEvtsClear(mEvts, SockEvtRead);
+
+	return success;
+}
+
+Success UnixListening::connectionsAccept()
+{
+	int peerFd, numErr;
+
+	if (mFdLst < 0)
+		return Pending;
+
+	peerFd = ::accept(mFdLst, NULL, NULL);
+	if (peerFd < 0)
+	{
+		numErr = errno;
+
+		if (numErr == EWOULDBLOCK || numErr == EAGAIN)
+			return Pending;
+
+		procWrnLog("accept() failed: %s (%d)", strerror(numErr), numErr);
+		return Pending;
+	}
+
+	if (ppPeerFd.isFull() || ppPeerFd.size() >= mMaxConn)
+	{
+		procWrnLog("dropping connection. Output queue full");
+		::close(peerFd);
+
+		// give internal side of system time
+		// to consume queue -> Pending
+		return Pending;
+	}
+
+	ppPeerFd.commit(peerFd, nowMs());
+	++mConnCreated;
+
+	return Positive;
+}
+
+void UnixListening::socketClose(int &fd)
+{
+	if (fd < 0)
+		return;
+
+	::close(fd);
+	fd = -1;
+}
+
+void UnixListening::processInfo(char *pBuf, char *pBufEnd)
+{
+	//dInfo("State\t\t\t%s\n", ProcStateString[mState]);
+	dInfo("%s\n", mPath.c_str());
+	dInfo("Connections created\t%d\n", (int)mConnCreated);
+	dInfo("Queue\t\t\t%zu\n", ppPeerFd.size());
+}
+
+/* static functions */
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/unix.7.html
+ *
+ * Return value
+ *   Positive path not existing or no server listening
+ *   < 0      server listening or path not probed
+ */
+Success UnixListening::socketPathFree(const struct sockaddr_un &addr, socklen_t lenAddr)
+{
+	int fd, opt, res, numErr;
+
+	fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	// Don't block on a full backlog
+	opt = fcntl(fd, F_GETFL, 0);
+	if (opt == -1 || fcntl(fd, F_SETFL, opt | O_NONBLOCK) == -1)
+	{
+		::close(fd);
+		return -1;
+	}
+
+	res = ::connect(fd, (const struct sockaddr *)&addr, lenAddr);
+	numErr = errno;
+
+	::close(fd);
+
+	if (!res)
+		return -2;
+
+	if (numErr == ECONNREFUSED || numErr == ENOENT)
+		return Positive;
+
+	// EAGAIN: Server listening with full backlog
+	return -3;
+}
+
+#endif
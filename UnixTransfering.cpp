@@ -0,0 +1,735 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <string.h>
+#include <stddef.h>
+#include <chrono>
+
+#include "UnixTransfering.h"
+
+#if CONFIG_PROC_HAVE_UNIX_SOCKETS
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#define dForEach_ProcState(gen) \
+		gen(StSrvStart) \
+		gen(StCltStart) \
+		gen(StCltConnDoneWait) \
+		gen(StConnMain) \
+		gen(StTmp) \
+
+#define dGenProcStateEnum(s) s,
+dProcessStateEnum(ProcState);
+
+#if 0
+#define dGenProcStateString(s) #s,
+dProcessStateStr(ProcState);
+#endif
+
+using namespace std;
+using namespace chrono;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifndef MSG_CMSG_CLOEXEC
+#define MSG_CMSG_CLOEXEC 0
+#endif
+
+#define dTmoDefaultConnDoneMs			2000
+
+UnixTransfering::UnixTransfering(int fd)
+	: Transfering("UnixTransfering")
+	, mStartMs(0)
+	, mSocketFd(fd)
+	, mEvts()
+	, mPath()
+	, mErrno(0)
+	, mReadDone(false)
+	, mBufSend()
+	, mIdxBufSend(0)
+	, mSendBlocked(false)
+	, mFdsRecv()
+	, mBytesReceived(0)
+	, mBytesSent(0)
+	, mFdsSent(0)
+	, mFdsReceived(0)
+{
+	mState = StSrvStart;
+}
+
+UnixTransfering::UnixTransfering(const string &path)
+	: Transfering("UnixTransfering")
+	, mStartMs(0)
+	, mSocketFd(-1)
+	, mEvts()
+	, mPath(path)
+	, mErrno(0)
+	, mReadDone(false)
+	, mBufSend()
+	, mIdxBufSend(0)
+	, mSendBlocked(false)
+	, mFdsRecv()
+	, mBytesReceived(0)
+	, mBytesSent(0)
+	, mFdsSent(0)
+	, mFdsReceived(0)
+{
+	mState = StCltStart;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/unix.7.html
+ * - https://man7.org/linux/man-pages/man2/connect.2.html
+ */
+Success UnixTransfering::process()
+{
+	uint32_t curTimeMs = millis();
+	uint32_t diffMs = curTimeMs - mStartMs;
+	struct sockaddr_un addr;
+	socklen_t lenAddr;
+	ssize_t connCheck;
+	int res, numErr;
+	bool ok;
+#if 0
+	dStateTrace;
+#endif
+	switch (mState)
+	{
+	case StSrvStart:
+
+		if (mSocketFd < 0)
+			return procErrLog(-1, "socket file descriptor not set");
+
+		ok = fileNonBlockingSet(mSocketFd);
+		if (!ok)
+			return procErrLog(-1, "could not set non blocking mode: %s",
+							errnoToStr(errno).c_str());
+
+		mReadReady = true;
+		mSendReady = true;
+
+		eventsRegister();
+
+		mState = StConnMain;
+
+		break;
+	case StCltStart:
+
+		ok = sockaddrUnixSet(mPath, addr, lenAddr);
+		if (!ok)
+			return procErrLog(-1, "invalid socket path. Given: '%s'", mPath.c_str());
+
+		mSocketFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (mSocketFd < 0)
+			return procErrLog(-1, "could not create socket: %s",
+							errnoToStr(errno).c_str());
+
+		ok = fileNonBlockingSet(mSocketFd);
+		if (!ok)
+			return procErrLog(-1, "could not set non blocking mode: %s",
+							errnoToStr(errno).c_str());
+
+		mStartMs = curTimeMs;
+		mState = StCltConnDoneWait;
+
+		break;
+	case StCltConnDoneWait:
+
+		if (diffMs > dTmoDefaultConnDoneMs)
+			return procErrLog(-1, "timeout connecting to %s", mPath.c_str());
+
+		sockaddrUnixSet(mPath, addr, lenAddr);
+
+		// Local connects complete at once or fail with a full backlog
+		res = ::connect(mSocketFd, (struct sockaddr *)&addr, lenAddr);
+		numErr = res ? errno : 0;
+
+		if (numErr == EAGAIN || numErr == EINPROGRESS || numErr == EALREADY)
+			break;
+
+		if (numErr && numErr != EISCONN)
+			return procErrLog(-1, "could not connect to %s: %s",
+							mPath.c_str(), errnoToStr(numErr).c_str());
+
+		mAddrRemote = mPath;
+		mReadReady = true;
+		mSendReady = true;
+
+		eventsRegister();
+
+		mState = StConnMain;
+
+		break;
+	case StConnMain:
+
+		sendQueueProcess();
+
+		if (mDone && !sendPending())
+			return Positive;
+
+		if (mReadDone)
+		{
+			mReadDone = false;
+			connCheck = socketValid() ? 0 : -1;
+		}
+		else
+		if (sockEvtsRegistered(mEvts) &&
+				!(sockEvtsGet(mEvts) & (SockEvtHup | SockEvtErr)))
+			connCheck = 0; // Idle connection. No syscall
+		else
+			connCheck = read(NULL, 0);
+
+		if (connCheck >= 0)
+			break;
+
+		if (mErrno)
+			return procErrLog(-1, "connection error occured: %s",
+							errnoToStr(mErrno).c_str());
+
+		return Positive;
+
+		break;
+	case StTmp:
+
+		break;
+	default:
+		break;
+	}
+
+	return Pending;
+}
+
+Success UnixTransfering::shutdown()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	disconnect();
+
+	// Descriptors not fetched by the user
+	while (mFdsRecv.size())
+	{
+		::close(mFdsRecv.front());
+		mFdsRecv.pop_front();
+	}
+
+	return Positive;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man2/recvmsg.2.html
+ * - https://man7.org/linux/man-pages/man3/cmsg.3.html
+ *
+ * Received descriptors are queued. See fdReceive()
+ */
+ssize_t UnixTransfering::read(void *pBuf, size_t lenReq)
+{
+	if (readMixed(pBuf, lenReq))
+		return procErrLog(-5, "data buffered by frame read. Don't mix with read()");
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (!mReadReady)
+		return 0;
+
+	if (mSocketFd < 0)
+		return -1;
+
+	if (sockEvtsRegistered(mEvts) &&
+			!(sockEvtsGet(mEvts) & (SockEvtRead | SockEvtHup | SockEvtErr)))
+		return 0;
+
+	union
+	{
+		char buf[CMSG_SPACE(sizeof(int) * CONFIG_PROC_UNIX_NUM_FDS_MAX)];
+		struct cmsghdr align;
+	} ctrl;
+	struct msghdr msg;
+	struct iovec vec;
+	ssize_t numBytes;
+	bool peek = false;
+	char buf[1];
+
+	if (!pBuf || !lenReq)
+	{
+		pBuf = buf;
+		lenReq = sizeof(buf);
+		peek = true;
+	}
+	else
+		mReadDone = true;
+
+	vec.iov_base = pBuf;
+	vec.iov_len = lenReq;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &vec;
+	msg.msg_iovlen = 1;
+
+	// Descriptors would be duplicated when peeking
+	if (!peek)
+	{
+		msg.msg_control = ctrl.buf;
+		msg.msg_controllen = sizeof(ctrl.buf);
+	}
+
+	numBytes = ::recvmsg(mSocketFd, &msg, peek ? MSG_PEEK : MSG_CMSG_CLOEXEC);
+	if (numBytes < 0)
+	{
+		int numErr = errno;
+
+		if (numErr == EWOULDBLOCK || numErr == EAGAIN)
+		{
+			sockEvtsClear(mEvts, SockEvtRead);
+			return 0; // std case and ok
+		}
+
+		if (numErr == ECONNRESET)
+		{
+			procDbgLog("connection reset by peer");
+			disconnect();
+			return -2;
+		}
+
+		disconnect(numErr);
+
+		return procErrLog(-3, "recvmsg() failed: %s",
+							errnoToStr(numErr).c_str());
+	}
+
+	if (!peek)
+		fdsReceivedStore(&msg);
+
+	if (!numBytes)
+	{
+		procDbgLog("connection closed by peer");
+		disconnect();
+		return -4;
+	}
+
+	if (peek)
+		return numBytes;
+
+	if ((size_t)numBytes < lenReq)
+		sockEvtsClear(mEvts, SockEvtRead);
+
+	mBytesReceived += numBytes;
+
+	return numBytes;
+}
+
+// Return: Number of bytes accepted. See TcpTransfering::send()
+ssize_t UnixTransfering::send(const void *pData, size_t lenReq)
+{
+	return fdSend(-1, pData, lenReq);
+}
+
+size_t UnixTransfering::sendPending() const
+{
+	return mBufSend.size() - mIdxBufSend;
+}
+
+bool UnixTransfering::sendBlocked() const
+{
+	return mSendBlocked;
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/unix.7.html
+ *   SCM_RIGHTS
+ *
+ * The descriptor is attached to the first byte of the data.
+ * It is duplicated into the peer and can be closed afterwards.
+ * Same return values as send()
+ */
+ssize_t UnixTransfering::fdSend(int fd, const void *pData, size_t lenReq)
+{
+	if (!mSendReady)
+		return procErrLog(-1, "unable to send data. Not ready");
+
+	if (fd >= 0 && !lenReq)
+		return procErrLog(-1, "descriptors require data");
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	// DO NOT SEND AN ERROR MESSAGE AT THIS POINT!
+	// See TcpTransfering::send()
+	if (mSocketFd < 0)
+		return -1;
+
+	size_t lenPending = mBufSend.size() - mIdxBufSend;
+	size_t lenQueue;
+	ssize_t res;
+
+	if (lenPending)
+	{
+		res = sendQueueFlush();
+		if (res < 0)
+			return res;
+
+		lenPending = mBufSend.size() - mIdxBufSend;
+	}
+
+	if (lenPending)
+	{
+		// Descriptors can't be queued. Try again later
+		if (fd >= 0)
+			return 0;
+
+		if (mSendBlocked || lenPending >= CONFIG_PROC_UNIX_SIZE_SEND_QUEUE)
+			return 0;
+
+		// Keep the order. Queue what fits
+		lenQueue = PMIN(lenReq, CONFIG_PROC_UNIX_SIZE_SEND_QUEUE - lenPending);
+		sendQueueAppend(pData, lenQueue);
+
+		return lenQueue;
+	}
+
+	res = socketSend(pData, lenReq, fd);
+	if (res <= 0)
+		return res;
+
+	if (fd >= 0)
+		++mFdsSent;
+
+	// The rest is queued up to the maximum size
+	lenQueue = PMIN(lenReq - res, (size_t)CONFIG_PROC_UNIX_SIZE_SEND_QUEUE);
+	sendQueueAppend((const uint8_t *)pData + res, lenQueue);
+
+	return res + lenQueue;
+}
+
+// Ownership is passed to the caller. -1 if none
+int UnixTransfering::fdReceive()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (!mFdsRecv.size())
+		return -1;
+
+	int fd = mFdsRecv.front();
+	mFdsRecv.pop_front();
+
+	return fd;
+}
+
+bool UnixTransfering::sockaddrUnixSet(const string &path,
+							struct sockaddr_un &addr,
+							socklen_t &lenAddr)
+{
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	if (!path.size() || path.size() >= sizeof(addr.sun_path))
+		return false;
+
+	memcpy(addr.sun_path, path.c_str(), path.size());
+#if defined(__linux__)
+	if (path[0] == '@')
+		addr.sun_path[0] = 0;
+#endif
+	lenAddr = offsetof(struct sockaddr_un, sun_path) + path.size() + 1;
+
+	// Abstract addresses are not null terminated
+	if (!addr.sun_path[0])
+		--lenAddr;
+
+	return true;
+}
+
+bool UnixTransfering::socketValid()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	return mSocketFd >= 0;
+}
+
+void UnixTransfering::eventsRegister()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (mSocketFd < 0)
+		return;
+
+	if (!sockEvtsRegister(mEvts, mSocketFd))
+		procDbgLog("socket events not available. Polling socket");
+}
+
+void UnixTransfering::sendQueueProcess()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mSocketFdMtx);
+#endif
+	if (mSocketFd < 0 || mIdxBufSend == mBufSend.size())
+		return;
+
+	// Without socket events we try every tick
+	if (sockEvtsRegistered(mEvts) && !(sockEvtsGet(mEvts) & (SockEvtWrite | SockEvtErr)))
+		return;
+
+	sendQueueFlush();
+}
+
+// Caller must lock
+void UnixTransfering::sendQueueAppend(const void *pData, size_t len)
+{
+	if (!len)
+		return;
+
+	// Compact lazily
+	if (mIdxBufSend && mIdxBufSend >= mBufSend.size() / 2)
+	{
+		mBufSend.erase(mBufSend.begin(), mBufSend.begin() + mIdxBufSend);
+		mIdxBufSend = 0;
+	}
+
+	mBufSend.insert(mBufSend.end(), (const uint8_t *)pData, (const uint8_t *)pData + len);
+
+	if (mBufSend.size() - mIdxBufSend >= CONFIG_PROC_UNIX_SIZE_SEND_QUEUE / 2)
+		mSendBlocked = true;
+
+	sockEvtsInterestSet(mEvts, SockEvtRead | SockEvtWrite);
+}
+
+// Caller must lock
+ssize_t UnixTransfering::sendQueueFlush()
+{
+	size_t lenPending = mBufSend.size() - mIdxBufSend;
+	ssize_t res;
+
+	if (!lenPending)
+		return 0;
+
+	res = socketSend(mBufSend.data() + mIdxBufSend, lenPending, -1);
+	if (res <= 0)
+		return res;
+
+	mIdxBufSend += res;
+	lenPending -= res;
+
+	if (lenPending <= CONFIG_PROC_UNIX_SIZE_SEND_QUEUE / 8)
+		mSendBlocked = false;
+
+	if (lenPending)
+		return res;
+
+	mBufSend.clear();
+	mIdxBufSend = 0;
+
+	sockEvtsInterestSet(mEvts, SockEvtRead);
+	sockEvtsClear(mEvts, SockEvtWrite);
+
+	return res;
+}
+
+// Caller must lock
+ssize_t UnixTransfering::socketSend(const void *pData, size_t len, int fdPass)
+{
+	union
+	{
+		char buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} ctrl;
+	struct cmsghdr *pCmsg;
+	struct msghdr msg;
+	struct iovec vec;
+	ssize_t res;
+
+	vec.iov_base = (void *)pData;
+	vec.iov_len = len;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &vec;
+	msg.msg_iovlen = 1;
+
+	if (fdPass >= 0)
+	{
+		memset(&ctrl, 0, sizeof(ctrl));
+
+		msg.msg_control = ctrl.buf;
+		msg.msg_controllen = sizeof(ctrl.buf);
+
+		pCmsg = CMSG_FIRSTHDR(&msg);
+		pCmsg->cmsg_level = SOL_SOCKET;
+		pCmsg->cmsg_type = SCM_RIGHTS;
+		pCmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(pCmsg), &fdPass, sizeof(int));
+	}
+
+	res = ::sendmsg(mSocketFd, &msg, MSG_NOSIGNAL);
+	if (res < 0)
+	{
+		int numErr = errno;
+
+		if (numErr == EWOULDBLOCK || numErr == EAGAIN)
+		{
+			sockEvtsClear(mEvts, SockEvtWrite);
+			return 0; // std case and ok
+		}
+
+		disconnect(numErr);
+
+		return procErrLog(-1, "connection down: %s",
+						errnoToStr(numErr).c_str());
+	}
+
+	mBytesSent += res;
+
+	return res;
+}
+
+// Caller must lock
+void UnixTransfering::fdsReceivedStore(struct msghdr *pMsg)
+{
+	struct cmsghdr *pCmsg;
+	size_t numFds, i;
+	int fd;
+
+	if (pMsg->msg_flags & MSG_CTRUNC)
+		procWrnLog("descriptors lost. Control buffer too small");
+
+	for (pCmsg = CMSG_FIRSTHDR(pMsg); pCmsg; pCmsg = CMSG_NXTHDR(pMsg, pCmsg))
+	{
+		if (pCmsg->cmsg_level != SOL_SOCKET || pCmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+
+		numFds = (pCmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+		for (i = 0; i < numFds; ++i)
+		{
+			memcpy(&fd, CMSG_DATA(pCmsg) + i * sizeof(int), sizeof(int));
+
+			mFdsRecv.push_back(fd);
+			++mFdsReceived;
+		}
+	}
+}
+
+void UnixTransfering::disconnect(int err)
+{
+	//Guard lock(mSocketFdMtx); // every caller must lock in advance!
+	if (mSocketFd < 0)
+		return;
+
+	procDbgLog("closing socket: %d", mSocketFd);
+	mErrno = err;
+
+	sockEvtsUnregister(mEvts);
+
+	mBufSend.clear();
+	mIdxBufSend = 0;
+	mSendBlocked = false;
+
+	::close(mSocketFd);
+	mSocketFd = -1;
+}
+
+void UnixTransfering::processInfo(char *pBuf, char *pBufEnd)
+{
+	//dInfo("State\t\t\t%s\n", ProcStateString[mState]);
+	dInfo("Bytes received\t\t%d\n", (int)mBytesReceived);
+	dInfo("Bytes queued\t\t%d%s\n", (int)sendPending(), mSendBlocked ? " (blocked)" : "");
+	dInfo("Descriptors\t\t%u sent, %u received\n", mFdsSent, mFdsReceived);
+
+	if (mPath.size())
+		dInfo("%s\n", mPath.c_str());
+}
+
+/* static functions */
+
+uint32_t UnixTransfering::millis()
+{
+	auto now = steady_clock::now();
+	auto nowMs = time_point_cast<milliseconds>(now);
+	return (uint32_t)nowMs.time_since_epoch().count();
+}
+
+bool UnixTransfering::fileNonBlockingSet(int fd)
+{
+	int opt;
+
+	opt = fcntl(fd, F_GETFL, 0);
+	if (opt == -1)
+		return false;
+
+	opt |= O_NONBLOCK;
+
+	opt = fcntl(fd, F_SETFL, opt);
+	if (opt == -1)
+		return false;
+
+	opt = fcntl(fd, F_GETFD, 0);
+	if (opt == -1)
+		return false;
+
+	// Don't leak into child processes
+	opt |= FD_CLOEXEC;
+
+	opt = fcntl(fd, F_SETFD, opt);
+	if (opt == -1)
+		return false;
+
+	return true;
+}
+
+string UnixTransfering::errnoToStr(int num)
+{
+	char buf[64];
+	size_t len = sizeof(buf) - 1;
+	char *pBuf;
+
+	buf[0] = 0;
+	buf[len] = 0;
+
+#if defined(__FreeBSD__) || defined(__APPLE__)
+	int res;
+
+	pBuf = buf;
+	res = ::strerror_r(num, buf, len);
+	if (res)
+		*pBuf = 0;
+#else
+	pBuf = ::strerror_r(num, buf, len);
+#endif
+	return string(pBuf);
+}
+
+#endif
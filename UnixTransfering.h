@@ -0,0 +1,163 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 18.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef UNIX_TRANSFERING_H
+#define UNIX_TRANSFERING_H
+
+#include <string>
+#include <deque>
+
+#include "Transfering.h"
+#include "SocketEvents.h"
+
+#ifndef CONFIG_PROC_HAVE_UNIX_SOCKETS
+#if defined(__unix__) || defined(__APPLE__)
+#define CONFIG_PROC_HAVE_UNIX_SOCKETS		1
+#else
+#define CONFIG_PROC_HAVE_UNIX_SOCKETS		0
+#endif
+#endif
+
+#ifndef CONFIG_PROC_UNIX_SIZE_SEND_QUEUE
+#define CONFIG_PROC_UNIX_SIZE_SEND_QUEUE	(256 * 1024)
+#endif
+
+// Per message
+#ifndef CONFIG_PROC_UNIX_NUM_FDS_MAX
+#define CONFIG_PROC_UNIX_NUM_FDS_MAX		16
+#endif
+
+#if CONFIG_PROC_HAVE_UNIX_SOCKETS
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Local stream connection. Paths starting with '@'
+ * use the abstract namespace on Linux
+ */
+class UnixTransfering : public Transfering
+{
+
+public:
+
+	static UnixTransfering *create(int fd)
+	{
+		return new (std::nothrow) UnixTransfering(fd);
+	}
+
+	static UnixTransfering *create(const std::string &path)
+	{
+		return new (std::nothrow) UnixTransfering(path);
+	}
+
+	ssize_t read(void *pBuf, size_t lenReq);
+	using Transfering::send;
+	ssize_t send(const void *pData, size_t lenReq);
+	size_t sendPending() const;
+	bool sendBlocked() const;
+
+	ssize_t fdSend(int fd, const void *pData, size_t lenReq);
+	int fdReceive();
+
+	static bool sockaddrUnixSet(const std::string &path,
+							struct sockaddr_un &addr,
+							socklen_t &lenAddr);
+
+protected:
+
+	virtual ~UnixTransfering() {}
+
+private:
+
+	UnixTransfering() = delete;
+	UnixTransfering(int fd);
+	UnixTransfering(const std::string &path);
+	UnixTransfering(const UnixTransfering &) = delete;
+	UnixTransfering &operator=(const UnixTransfering &) = delete;
+
+	/*
+	 * Naming of functions:  objectVerb()
+	 * Example:              peerAdd()
+	 */
+
+	/* member functions */
+	Success process();
+	Success shutdown();
+
+	bool socketValid();
+	void eventsRegister();
+	void sendQueueProcess();
+	void sendQueueAppend(const void *pData, size_t len);
+	ssize_t sendQueueFlush();
+	ssize_t socketSend(const void *pData, size_t len, int fdPass);
+	void fdsReceivedStore(struct msghdr *pMsg);
+	void disconnect(int err = 0);
+	void processInfo(char *pBuf, char *pBufEnd);
+
+	/* member variables */
+	uint32_t mStartMs;
+#if CONFIG_PROC_HAVE_DRIVERS
+	std::mutex mSocketFdMtx;
+#endif
+	int mSocketFd;
+	SocketEvents mEvts;
+	std::string mPath;
+	int mErrno;
+	bool mReadDone;
+
+	// send queue
+	VecByte mBufSend;
+	size_t mIdxBufSend;
+	bool mSendBlocked;
+
+	// descriptors received via SCM_RIGHTS
+	std::deque<int> mFdsRecv;
+
+	// statistics
+	size_t mBytesReceived;
+	size_t mBytesSent;
+	uint32_t mFdsSent;
+	uint32_t mFdsReceived;
+
+	/* static functions */
+	static uint32_t millis();
+	static bool fileNonBlockingSet(int fd);
+	static std::string errnoToStr(int num);
+
+	/* static variables */
+
+	/* constants */
+
+};
+
+#endif
+
+#endif